@@ -0,0 +1,23 @@
+#include "async_search.h"
+
+AsyncSearchServer::AsyncSearchServer(const SearchServer& search_server, size_t thread_count, size_t queue_capacity)
+        : search_server_(search_server)
+        , pool_(thread_count, queue_capacity) {}
+
+AsyncResult<std::vector<Document>> AsyncSearchServer::SubmitQuery(std::string raw_query, DocumentStatus status,
+                                                                  Deadline deadline) {
+    return Submit<std::vector<Document>>(deadline, [this, raw_query = std::move(raw_query), status](const QueryControl& control) {
+        return search_server_.FindTopDocuments(raw_query, status, control);
+    });
+}
+
+AsyncResult<AsyncSearchServer::MatchResult> AsyncSearchServer::SubmitMatch(std::string raw_query, int document_id,
+                                                                           Deadline deadline) {
+    return Submit<MatchResult>(deadline, [this, raw_query = std::move(raw_query), document_id](const QueryControl&) {
+        return search_server_.MatchDocument(raw_query, document_id);
+    });
+}
+
+size_t AsyncSearchServer::QueueSize() const {
+    return pool_.QueueSize();
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include "query_control.h"
+#include "search_server.h"
+#include "thread_pool.h"
+
+class QueryRejected : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+template <typename Result>
+struct AsyncResult {
+    std::future<Result> result;
+    std::shared_ptr<QueryControl> control;
+
+    void Cancel() const {
+        control->Cancel();
+    }
+};
+
+// Non-blocking front-end: queries run on a dedicated bounded pool instead of
+// the caller's thread. A full queue makes Submit* throw QueryRejected right
+// away, so overload shows up as rejections rather than unbounded latency.
+// A query past its deadline or cancelled through its handle stops inside the
+// scoring loop and its future holds QueryCancelled.
+// The SearchServer must outlive this object and must not be modified while
+// queries are in flight.
+class AsyncSearchServer {
+public:
+    using Deadline = QueryControl::Clock::time_point;
+    using MatchResult = std::tuple<std::vector<std::string_view>, DocumentStatus>;
+
+    AsyncSearchServer(const SearchServer& search_server, size_t thread_count, size_t queue_capacity);
+
+    AsyncResult<std::vector<Document>> SubmitQuery(std::string raw_query,
+                                                   DocumentStatus status = DocumentStatus::ACTUAL,
+                                                   Deadline deadline = Deadline::max());
+    AsyncResult<MatchResult> SubmitMatch(std::string raw_query, int document_id,
+                                         Deadline deadline = Deadline::max());
+
+    size_t QueueSize() const;
+
+private:
+    const SearchServer& search_server_;
+    BoundedThreadPool pool_;
+
+    template <typename Result, typename Func>
+    AsyncResult<Result> Submit(Deadline deadline, Func func);
+};
+
+template <typename Result, typename Func>
+AsyncResult<Result> AsyncSearchServer::Submit(Deadline deadline, Func func) {
+    using std::string_literals::operator""s;
+    auto control = std::make_shared<QueryControl>(deadline);
+    auto task = std::make_shared<std::packaged_task<Result()>>([control, func = std::move(func)] {
+        // the query may have expired or been cancelled while queued
+        control->ThrowIfCancelled();
+        return func(*control);
+    });
+    auto result = task->get_future();
+    if (!pool_.TrySubmit([task] { (*task)(); })) {
+        throw QueryRejected("Query queue is full"s);
+    }
+    return {std::move(result), std::move(control)};
+}
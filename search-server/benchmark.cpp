@@ -0,0 +1,383 @@
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <numeric>
+#include <sstream>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "benchmark.h"
+#include "document_loader.h"
+#include "mapped_index.h"
+#include "process_queries.h"
+#include "remove_duplicates.h"
+
+using std::string_literals::operator""s;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template <typename Operation>
+std::chrono::nanoseconds Measure(Operation operation) {
+    const auto start_time = Clock::now();
+    operation();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_time);
+}
+
+// keeps the optimizer from dropping results of measured calls
+double sink = 0;
+
+std::vector<std::vector<int>> GenerateRatings(std::mt19937& generator, int document_count) {
+    std::vector<std::vector<int>> ratings(document_count);
+    for (auto& document_ratings : ratings) {
+        const int count = std::uniform_int_distribution(0, 5)(generator);
+        for (int i = 0; i < count; ++i) {
+            document_ratings.push_back(std::uniform_int_distribution(-10, 10)(generator));
+        }
+    }
+    return ratings;
+}
+
+struct Corpus {
+    std::vector<std::string> dictionary;
+    std::vector<std::string> documents;
+    std::vector<std::vector<int>> ratings;
+    std::vector<std::string> queries;
+};
+
+Corpus GenerateCorpus(const BenchmarkConfig& config) {
+    std::mt19937 generator(config.seed);
+    Corpus corpus;
+    corpus.dictionary = GenerateDictionary(generator, config.dictionary_size, config.max_word_length);
+    corpus.documents = GenerateQueries(generator, corpus.dictionary, config.document_count, config.document_word_count);
+    corpus.ratings = GenerateRatings(generator, config.document_count);
+    corpus.queries = GenerateQueries(generator, corpus.dictionary, config.query_count,
+                                     config.query_word_count, config.minus_prob);
+    return corpus;
+}
+
+void FillServer(SearchServer& search_server, const Corpus& corpus) {
+    for (size_t i = 0; i < corpus.documents.size(); ++i) {
+        search_server.AddDocument(static_cast<int>(i), corpus.documents[i], DocumentStatus::ACTUAL, corpus.ratings[i]);
+    }
+}
+
+BenchmarkResult BenchAddDocument(const BenchmarkConfig& config, const Corpus& corpus) {
+    BenchmarkResult result{"add_document"s, {}};
+    for (int repetition = 0; repetition < config.repetitions; ++repetition) {
+        SearchServer search_server(corpus.dictionary[0]);
+        for (size_t i = 0; i < corpus.documents.size(); ++i) {
+            result.samples.push_back(Measure([&] {
+                search_server.AddDocument(static_cast<int>(i), corpus.documents[i],
+                                          DocumentStatus::ACTUAL, corpus.ratings[i]);
+            }));
+        }
+    }
+    return result;
+}
+
+// a sample is the whole corpus streamed through LoadDocuments
+BenchmarkResult BenchLoadDocuments(const BenchmarkConfig& config, const Corpus& corpus) {
+    std::string input;
+    for (size_t i = 0; i < corpus.documents.size(); ++i) {
+        input += std::to_string(i) + "\tACTUAL\t"s;
+        for (const int rating : corpus.ratings[i]) {
+            input += std::to_string(rating) + " "s;
+        }
+        input += "\t"s + corpus.documents[i] + "\n"s;
+    }
+    BenchmarkResult result{"load_documents"s, {}};
+    for (int repetition = 0; repetition < config.repetitions; ++repetition) {
+        SearchServer search_server(corpus.dictionary[0]);
+        std::istringstream stream(input);
+        result.samples.push_back(Measure([&] {
+            sink += LoadDocuments(search_server, stream);
+        }));
+    }
+    return result;
+}
+
+template <typename ExecutionPolicy>
+BenchmarkResult BenchRemoveDocument(const std::string& name, const BenchmarkConfig& config,
+                                    const Corpus& corpus, ExecutionPolicy policy) {
+    BenchmarkResult result{name, {}};
+    for (int repetition = 0; repetition < config.repetitions; ++repetition) {
+        SearchServer search_server(corpus.dictionary[0]);
+        FillServer(search_server, corpus);
+        // every tenth document, so the index stays populated while removing
+        for (int document_id = repetition; document_id < config.document_count; document_id += 10) {
+            result.samples.push_back(Measure([&] {
+                search_server.RemoveDocument(policy, document_id);
+            }));
+        }
+    }
+    return result;
+}
+
+template <typename ExecutionPolicy>
+BenchmarkResult BenchFindTopDocuments(const std::string& name, const BenchmarkConfig& config,
+                                      const SearchServer& search_server, const Corpus& corpus,
+                                      ExecutionPolicy policy) {
+    BenchmarkResult result{name, {}};
+    for (int repetition = 0; repetition < config.repetitions; ++repetition) {
+        for (const std::string_view query : corpus.queries) {
+            result.samples.push_back(Measure([&] {
+                for (const Document& document : search_server.FindTopDocuments(policy, query)) {
+                    sink += document.relevance;
+                }
+            }));
+        }
+    }
+    return result;
+}
+
+// the same queries against the server's image mapped from shared memory
+BenchmarkResult BenchFindTopDocumentsMapped(const BenchmarkConfig& config, const SearchServer& search_server,
+                                            const Corpus& corpus) {
+    const std::string name = "/search-server-benchmark-"s + std::to_string(getpid());
+    SaveIndexToSharedMemory(search_server, name);
+    const MappedIndex index = MappedIndex::OpenSharedMemory(name);
+    shm_unlink(name.c_str());
+    BenchmarkResult result{"find_top_documents_mapped"s, {}};
+    for (int repetition = 0; repetition < config.repetitions; ++repetition) {
+        for (const std::string_view query : corpus.queries) {
+            result.samples.push_back(Measure([&] {
+                for (const Document& document : index.FindTopDocuments(query)) {
+                    sink += document.relevance;
+                }
+            }));
+        }
+    }
+    return result;
+}
+
+template <typename ExecutionPolicy>
+BenchmarkResult BenchMatchDocument(const std::string& name, const BenchmarkConfig& config,
+                                   const SearchServer& search_server, const Corpus& corpus,
+                                   ExecutionPolicy policy) {
+    BenchmarkResult result{name, {}};
+    const int document_count = search_server.GetDocumentCount();
+    for (int repetition = 0; repetition < config.repetitions; ++repetition) {
+        for (size_t i = 0; i < corpus.queries.size(); ++i) {
+            const int document_id = static_cast<int>((i * 7919 + repetition) % document_count);
+            result.samples.push_back(Measure([&] {
+                const auto [words, status] = search_server.MatchDocument(policy, corpus.queries[i], document_id);
+                sink += words.size();
+            }));
+        }
+    }
+    return result;
+}
+
+// a sample is one query matched against every document, every 100th query is used
+template <typename ExecutionPolicy>
+BenchmarkResult BenchMatchDocuments(const std::string& name, const BenchmarkConfig& config,
+                                    const SearchServer& search_server, const Corpus& corpus,
+                                    ExecutionPolicy policy) {
+    BenchmarkResult result{name, {}};
+    for (int repetition = 0; repetition < config.repetitions; ++repetition) {
+        for (size_t i = 0; i < corpus.queries.size(); i += 100) {
+            result.samples.push_back(Measure([&] {
+                sink += search_server.MatchDocuments(policy, corpus.queries[i], search_server).size();
+            }));
+        }
+    }
+    return result;
+}
+
+// a sample is one whole batch of queries
+BenchmarkResult BenchProcessQueries(const BenchmarkConfig& config,
+                                    const SearchServer& search_server, const Corpus& corpus) {
+    BenchmarkResult result{"process_queries"s, {}};
+    for (int repetition = 0; repetition < config.repetitions; ++repetition) {
+        result.samples.push_back(Measure([&] {
+            sink += ProcessQueries(search_server, corpus.queries).size();
+        }));
+    }
+    return result;
+}
+
+BenchmarkResult BenchProcessQueriesJoined(const BenchmarkConfig& config,
+                                          const SearchServer& search_server, const Corpus& corpus) {
+    BenchmarkResult result{"process_queries_joined"s, {}};
+    for (int repetition = 0; repetition < config.repetitions; ++repetition) {
+        result.samples.push_back(Measure([&] {
+            sink += ProcessQueriesJoined(search_server, corpus.queries).size();
+        }));
+    }
+    return result;
+}
+
+// every fifth document is a reordered copy of its predecessor
+BenchmarkResult BenchRemoveDuplicates(const BenchmarkConfig& config, const Corpus& corpus) {
+    BenchmarkResult result{"remove_duplicates"s, {}};
+    for (int repetition = 0; repetition < config.repetitions; ++repetition) {
+        SearchServer search_server(corpus.dictionary[0]);
+        for (size_t i = 0; i < corpus.documents.size(); ++i) {
+            std::string text = corpus.documents[i];
+            if (i % 5 == 4) {
+                auto words = SplitIntoWords(corpus.documents[i - 1]);
+                std::reverse(words.begin(), words.end());
+                text.clear();
+                for (const std::string_view word : words) {
+                    text += " "s + std::string(word);
+                }
+            }
+            search_server.AddDocument(static_cast<int>(i), text, DocumentStatus::ACTUAL, corpus.ratings[i]);
+        }
+        std::ostringstream discarded;
+        auto* old_buffer = std::cout.rdbuf(discarded.rdbuf());
+        result.samples.push_back(Measure([&] {
+            RemoveDuplicates(search_server);
+        }));
+        std::cout.rdbuf(old_buffer);
+    }
+    return result;
+}
+
+void PrintCsvRow(std::ostream& out, const BenchmarkResult& result) {
+    out << result.name << ','
+        << result.samples.size() << ','
+        << result.Total().count() << ','
+        << result.OperationsPerSecond() << ','
+        << result.Percentile(0.5).count() << ','
+        << result.Percentile(0.9).count() << ','
+        << result.Percentile(0.99).count() << ','
+        << result.Percentile(1.0).count() << '\n';
+}
+
+void PrintJsonObject(std::ostream& out, const BenchmarkResult& result) {
+    out << "    {\"name\": \""s << result.name << "\", "s
+        << "\"operations\": "s << result.samples.size() << ", "s
+        << "\"total_ns\": "s << result.Total().count() << ", "s
+        << "\"ops_per_sec\": "s << result.OperationsPerSecond() << ", "s
+        << "\"p50_ns\": "s << result.Percentile(0.5).count() << ", "s
+        << "\"p90_ns\": "s << result.Percentile(0.9).count() << ", "s
+        << "\"p99_ns\": "s << result.Percentile(0.99).count() << ", "s
+        << "\"max_ns\": "s << result.Percentile(1.0).count() << "}"s;
+}
+
+} // namespace
+
+std::string GenerateWord(std::mt19937& generator, int max_length) {
+    const int length = std::uniform_int_distribution(1, max_length)(generator);
+    std::string word;
+    word.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        word.push_back(std::uniform_int_distribution('a', 'z')(generator));
+    }
+    return word;
+}
+
+std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length) {
+    std::vector<std::string> words;
+    words.reserve(word_count);
+    for (int i = 0; i < word_count; ++i) {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    return words;
+}
+
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                          int word_count, double minus_prob) {
+    std::string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (std::uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+            query.push_back('-');
+        }
+        query += dictionary[std::uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+    }
+    return query;
+}
+
+std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                                         int query_count, int max_word_count, double minus_prob) {
+    std::vector<std::string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, max_word_count, minus_prob));
+    }
+    return queries;
+}
+
+std::chrono::nanoseconds BenchmarkResult::Total() const {
+    return std::accumulate(samples.begin(), samples.end(), std::chrono::nanoseconds{0});
+}
+
+// nearest-rank percentile, p in [0, 1]
+std::chrono::nanoseconds BenchmarkResult::Percentile(double p) const {
+    if (samples.empty()) {
+        return std::chrono::nanoseconds{0};
+    }
+    auto sorted = samples;
+    const size_t rank = std::min(sorted.size() - 1,
+                                 static_cast<size_t>(std::ceil(p * sorted.size())) - (p > 0 ? 1 : 0));
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+double BenchmarkResult::OperationsPerSecond() const {
+    const auto total = Total().count();
+    return total == 0 ? 0.0 : samples.size() * 1e9 / total;
+}
+
+std::vector<BenchmarkResult> RunBenchmarks(const BenchmarkConfig& config) {
+    const Corpus corpus = GenerateCorpus(config);
+    SearchServer search_server(corpus.dictionary[0]);
+    FillServer(search_server, corpus);
+
+    std::vector<BenchmarkResult> results;
+    results.push_back(BenchAddDocument(config, corpus));
+    results.push_back(BenchLoadDocuments(config, corpus));
+    results.push_back(BenchRemoveDocument("remove_document_seq"s, config, corpus, std::execution::seq));
+    results.push_back(BenchRemoveDocument("remove_document_par"s, config, corpus, std::execution::par));
+    results.push_back(BenchFindTopDocuments("find_top_documents_seq"s, config, search_server, corpus, std::execution::seq));
+    results.push_back(BenchFindTopDocuments("find_top_documents_par"s, config, search_server, corpus, std::execution::par));
+    {
+        IndexOptions options;
+        options.scoring = Scoring::BM25;
+        SearchServer bm25_server(corpus.dictionary[0], options);
+        FillServer(bm25_server, corpus);
+        results.push_back(BenchFindTopDocuments("find_top_documents_bm25"s, config, bm25_server, corpus, std::execution::seq));
+    }
+    results.push_back(BenchFindTopDocumentsMapped(config, search_server, corpus));
+    results.push_back(BenchMatchDocument("match_document_seq"s, config, search_server, corpus, std::execution::seq));
+    results.push_back(BenchMatchDocument("match_document_par"s, config, search_server, corpus, std::execution::par));
+    results.push_back(BenchMatchDocuments("match_documents_seq"s, config, search_server, corpus, std::execution::seq));
+    results.push_back(BenchMatchDocuments("match_documents_par"s, config, search_server, corpus, std::execution::par));
+    results.push_back(BenchProcessQueries(config, search_server, corpus));
+    results.push_back(BenchProcessQueriesJoined(config, search_server, corpus));
+    results.push_back(BenchRemoveDuplicates(config, corpus));
+    return results;
+}
+
+void PrintBenchmarkResults(std::ostream& out, const BenchmarkConfig& config,
+                           const std::vector<BenchmarkResult>& results, BenchmarkFormat format) {
+    if (format == BenchmarkFormat::CSV) {
+        out << "name,operations,total_ns,ops_per_sec,p50_ns,p90_ns,p99_ns,max_ns\n"s;
+        for (const BenchmarkResult& result : results) {
+            PrintCsvRow(out, result);
+        }
+        return;
+    }
+    out << "{\n  \"config\": {"s
+        << "\"documents\": "s << config.document_count << ", "s
+        << "\"dictionary\": "s << config.dictionary_size << ", "s
+        << "\"max_word_length\": "s << config.max_word_length << ", "s
+        << "\"document_words\": "s << config.document_word_count << ", "s
+        << "\"queries\": "s << config.query_count << ", "s
+        << "\"query_words\": "s << config.query_word_count << ", "s
+        << "\"minus_prob\": "s << config.minus_prob << ", "s
+        << "\"repetitions\": "s << config.repetitions << ", "s
+        << "\"seed\": "s << config.seed << "},\n"s
+        << "  \"results\": [\n"s;
+    for (size_t i = 0; i < results.size(); ++i) {
+        PrintJsonObject(out, results[i]);
+        out << (i + 1 < results.size() ? ",\n"s : "\n"s);
+    }
+    out << "  ]\n}\n"s;
+}
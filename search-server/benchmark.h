@@ -0,0 +1,46 @@
+#pragma once
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "search_server.h"
+
+std::string GenerateWord(std::mt19937& generator, int max_length);
+std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length);
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                          int word_count, double minus_prob = 0);
+std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                                         int query_count, int max_word_count, double minus_prob = 0);
+
+// knobs of the generated corpus and query set
+struct BenchmarkConfig {
+    int document_count = 10'000;
+    int dictionary_size = 1'000;
+    int max_word_length = 10;
+    int document_word_count = 70;
+    int query_count = 100;
+    int query_word_count = 10;
+    double minus_prob = 0.0;
+    int repetitions = 5;
+    unsigned int seed = std::mt19937::default_seed;
+};
+
+// one benchmark case: every sample is the latency of a single operation
+struct BenchmarkResult {
+    std::string name;
+    std::vector<std::chrono::nanoseconds> samples;
+
+    std::chrono::nanoseconds Total() const;
+    std::chrono::nanoseconds Percentile(double p) const;
+    double OperationsPerSecond() const;
+};
+
+enum class BenchmarkFormat {
+    CSV,
+    JSON,
+};
+
+std::vector<BenchmarkResult> RunBenchmarks(const BenchmarkConfig& config);
+void PrintBenchmarkResults(std::ostream& out, const BenchmarkConfig& config,
+                           const std::vector<BenchmarkResult>& results, BenchmarkFormat format);
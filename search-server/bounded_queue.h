@@ -0,0 +1,110 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+
+// Blocking FIFO of limited capacity, used between the stages of the
+// document loader and as the task queue of BoundedThreadPool.
+// Push waits for a free slot (backpressure), TryPush refuses the item when
+// the queue is full (admission control), Pop waits for an item. After
+// Close, pushes fail at once and Pop hands out what is left, then returns
+// nullopt.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity);
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // false if the queue was closed before the item got in
+    bool Push(T item);
+    // false if the queue is full or closed
+    bool TryPush(T item);
+    std::optional<T> Pop();
+    void Close();
+
+    size_t Size() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<T> items_;
+    const size_t capacity_;
+    bool closed_ = false;
+};
+
+template <typename T>
+BoundedQueue<T>::BoundedQueue(size_t capacity)
+        : capacity_(capacity) {
+    using std::string_literals::operator""s;
+    if (capacity == 0) {
+        throw std::invalid_argument("Queue needs at least one slot"s);
+    }
+}
+
+template <typename T>
+bool BoundedQueue<T>::Push(T item) {
+    {
+        std::unique_lock lock(mutex_);
+        not_full_.wait(lock, [this] {
+            return closed_ || items_.size() < capacity_;
+        });
+        if (closed_) {
+            return false;
+        }
+        items_.push_back(std::move(item));
+    }
+    not_empty_.notify_one();
+    return true;
+}
+
+template <typename T>
+bool BoundedQueue<T>::TryPush(T item) {
+    {
+        std::lock_guard guard(mutex_);
+        if (closed_ || items_.size() >= capacity_) {
+            return false;
+        }
+        items_.push_back(std::move(item));
+    }
+    not_empty_.notify_one();
+    return true;
+}
+
+template <typename T>
+std::optional<T> BoundedQueue<T>::Pop() {
+    std::optional<T> item;
+    {
+        std::unique_lock lock(mutex_);
+        not_empty_.wait(lock, [this] {
+            return closed_ || !items_.empty();
+        });
+        if (items_.empty()) {
+            return item;
+        }
+        item = std::move(items_.front());
+        items_.pop_front();
+    }
+    not_full_.notify_one();
+    return item;
+}
+
+template <typename T>
+void BoundedQueue<T>::Close() {
+    {
+        std::lock_guard guard(mutex_);
+        closed_ = true;
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+}
+
+template <typename T>
+size_t BoundedQueue<T>::Size() const {
+    std::lock_guard guard(mutex_);
+    return items_.size();
+}
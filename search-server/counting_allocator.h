@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+using MemoryCounter = std::atomic<size_t>;
+
+// Forwards to std::allocator and keeps a running total of the bytes it holds
+// in a counter owned by whoever reports it. Copies and rebinds share the
+// counter, so a container and everything built from its allocator add up to
+// one figure. The allocator is a single pointer; the counter must outlive
+// every container that uses it.
+template <typename T>
+class CountingAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    // counts into a process-wide counter nobody reports, for containers
+    // outside an index
+    CountingAllocator() noexcept
+            : counter_(&UntrackedCounter()) {}
+
+    explicit CountingAllocator(MemoryCounter& counter) noexcept
+            : counter_(&counter) {}
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) noexcept
+            : counter_(other.Counter()) {}
+
+    T* allocate(size_t n) {
+        T* result = std::allocator<T>{}.allocate(n);
+        counter_->fetch_add(n * sizeof(T), std::memory_order_relaxed);
+        return result;
+    }
+
+    void deallocate(T* p, size_t n) {
+        counter_->fetch_sub(n * sizeof(T), std::memory_order_relaxed);
+        std::allocator<T>{}.deallocate(p, n);
+    }
+
+    MemoryCounter* Counter() const noexcept {
+        return counter_;
+    }
+
+private:
+    MemoryCounter* counter_;
+
+    static MemoryCounter& UntrackedCounter() {
+        static MemoryCounter counter{0};
+        return counter;
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const CountingAllocator<T>& lhs, const CountingAllocator<U>& rhs) {
+    return lhs.Counter() == rhs.Counter();
+}
+
+template <typename T, typename U>
+bool operator!=(const CountingAllocator<T>& lhs, const CountingAllocator<U>& rhs) {
+    return !(lhs == rhs);
+}
+
+template <typename Key, typename Value, typename Compare = std::less<Key>>
+using CountedMap = std::map<Key, Value, Compare, CountingAllocator<std::pair<const Key, Value>>>;
+
+template <typename Key, typename Compare = std::less<Key>>
+using CountedSet = std::set<Key, Compare, CountingAllocator<Key>>;
+
+template <typename T>
+using CountedVector = std::vector<T, CountingAllocator<T>>;
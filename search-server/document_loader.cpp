@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <thread>
+#include "bounded_queue.h"
+#include "document_loader.h"
+
+using std::string_literals::operator""s;
+using std::string_view_literals::operator""sv;
+
+namespace {
+
+struct Chunk {
+    size_t sequence;
+    size_t first_line;
+    std::shared_ptr<const std::string> text;
+};
+
+struct ParsedLine {
+    size_t line_number;
+    SearchServer::ParsedDocument document;
+};
+
+struct ParsedChunk {
+    size_t sequence;
+    // owns the characters the parsed words point to
+    std::shared_ptr<const std::string> text;
+    std::vector<ParsedLine> lines;
+    // a bad line ends the chunk: the lines parsed before it are still added
+    std::optional<std::string> error;
+};
+
+std::string LineError(size_t line_number, const std::string& message) {
+    return "Line "s + std::to_string(line_number) + ": "s + message;
+}
+
+int ParseInt(const std::string_view text) {
+    int value = 0;
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc() || end != text.data() + text.size()) {
+        throw std::invalid_argument("Invalid number "s + std::string(text));
+    }
+    return value;
+}
+
+DocumentStatus ParseStatus(const std::string_view text) {
+    if (text == "ACTUAL"sv) {
+        return DocumentStatus::ACTUAL;
+    }
+    if (text == "IRRELEVANT"sv) {
+        return DocumentStatus::IRRELEVANT;
+    }
+    if (text == "BANNED"sv) {
+        return DocumentStatus::BANNED;
+    }
+    if (text == "REMOVED"sv) {
+        return DocumentStatus::REMOVED;
+    }
+    throw std::invalid_argument("Invalid status "s + std::string(text));
+}
+
+SearchServer::ParsedDocument ParseLine(const SearchServer& search_server, const std::string_view line) {
+    std::string_view fields[3];
+    size_t start = 0;
+    for (std::string_view& field : fields) {
+        const size_t tab = line.find('\t', start);
+        if (tab == line.npos) {
+            throw std::invalid_argument("Expected id, status, ratings and text separated by tabs"s);
+        }
+        field = line.substr(start, tab - start);
+        start = tab + 1;
+    }
+    std::vector<int> ratings;
+    for (const std::string_view rating : SplitIntoWords(fields[2])) {
+        ratings.push_back(ParseInt(rating));
+    }
+    return search_server.ParseDocument(ParseInt(fields[0]), line.substr(start), ParseStatus(fields[1]), ratings);
+}
+
+ParsedChunk ParseChunk(const SearchServer& search_server, Chunk&& chunk) {
+    ParsedChunk result{chunk.sequence, std::move(chunk.text), {}, std::nullopt};
+    const std::string_view text = *result.text;
+    size_t line_number = chunk.first_line;
+    for (size_t start = 0; start < text.size(); ++line_number) {
+        const size_t end = std::min(text.find('\n', start), text.size());
+        std::string_view line = text.substr(start, end - start);
+        start = end + 1;
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.empty()) {
+            continue;
+        }
+        try {
+            result.lines.push_back({line_number, ParseLine(search_server, line)});
+        } catch (const std::invalid_argument& e) {
+            result.error = LineError(line_number, e.what());
+            break;
+        }
+    }
+    return result;
+}
+
+// cuts the input after the last complete line of every read; stops early
+// once the queue is closed by a failing stage
+void ReadChunks(std::istream& input, size_t chunk_size, BoundedQueue<Chunk>& chunks) {
+    size_t sequence = 0;
+    size_t line = 1;
+    std::string carry;
+    bool at_end = false;
+    while (!at_end) {
+        auto text = std::make_shared<std::string>(std::move(carry));
+        carry.clear();
+        const size_t old_size = text->size();
+        text->resize(old_size + chunk_size);
+        input.read(text->data() + old_size, static_cast<std::streamsize>(chunk_size));
+        text->resize(old_size + static_cast<size_t>(input.gcount()));
+        at_end = !input;
+        if (input.bad()) {
+            throw std::runtime_error("Failed to read documents"s);
+        }
+        if (!at_end) {
+            const size_t last_newline = text->rfind('\n');
+            if (last_newline == text->npos) {
+                carry = std::move(*text);
+                continue;
+            }
+            carry.assign(*text, last_newline + 1);
+            text->resize(last_newline + 1);
+        }
+        if (text->empty()) {
+            continue;
+        }
+        const size_t line_count = std::count(text->begin(), text->end(), '\n');
+        if (!chunks.Push({sequence++, line, std::move(text)})) {
+            return;
+        }
+        line += line_count;
+    }
+}
+
+} // namespace
+
+size_t LoadDocuments(SearchServer& search_server, std::istream& input, const LoadOptions& options) {
+    if (options.chunk_size == 0) {
+        throw std::invalid_argument("Chunk size must be positive"s);
+    }
+    const size_t worker_count = options.worker_count > 0
+                                ? options.worker_count
+                                : std::max(1u, std::thread::hardware_concurrency());
+    BoundedQueue<Chunk> chunks(options.queue_capacity);
+    BoundedQueue<ParsedChunk> parsed_chunks(options.queue_capacity);
+
+    std::mutex failure_mutex;
+    std::exception_ptr failure;
+    // the first failure wins and shuts every stage down
+    const auto fail = [&](std::exception_ptr error) {
+        {
+            std::lock_guard guard(failure_mutex);
+            if (!failure) {
+                failure = error;
+            }
+        }
+        chunks.Close();
+        parsed_chunks.Close();
+    };
+
+    std::thread reader([&] {
+        try {
+            ReadChunks(input, options.chunk_size, chunks);
+        } catch (...) {
+            fail(std::current_exception());
+        }
+        chunks.Close();
+    });
+    std::atomic<size_t> running_workers = worker_count;
+    std::vector<std::thread> workers;
+    workers.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back([&] {
+            try {
+                while (auto chunk = chunks.Pop()) {
+                    if (!parsed_chunks.Push(ParseChunk(search_server, std::move(*chunk)))) {
+                        break;
+                    }
+                }
+            } catch (...) {
+                fail(std::current_exception());
+            }
+            if (--running_workers == 0) {
+                parsed_chunks.Close();
+            }
+        });
+    }
+
+    // workers finish out of order, so chunks wait here for their predecessors
+    size_t added = 0;
+    size_t next_sequence = 0;
+    std::map<size_t, ParsedChunk> pending;
+    try {
+        while (auto parsed_chunk = parsed_chunks.Pop()) {
+            pending.emplace(parsed_chunk->sequence, std::move(*parsed_chunk));
+            for (auto iter = pending.begin(); iter != pending.end() && iter->first == next_sequence;
+                 iter = pending.erase(iter), ++next_sequence) {
+                for (ParsedLine& line : iter->second.lines) {
+                    try {
+                        search_server.AddDocument(std::move(line.document));
+                    } catch (const std::invalid_argument& e) {
+                        throw std::invalid_argument(LineError(line.line_number, e.what()));
+                    }
+                    ++added;
+                }
+                if (iter->second.error) {
+                    throw std::invalid_argument(*iter->second.error);
+                }
+            }
+        }
+    } catch (...) {
+        fail(std::current_exception());
+    }
+    reader.join();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+    return added;
+}
+
+size_t LoadDocuments(SearchServer& search_server, const std::string& path, const LoadOptions& options) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Cannot open "s + path);
+    }
+    return LoadDocuments(search_server, input, options);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <istream>
+#include <string>
+#include "search_server.h"
+
+// Corpus format: one document per line, four tab-separated fields
+//   id <TAB> status <TAB> ratings <TAB> text
+// status is ACTUAL, IRRELEVANT, BANNED or REMOVED; ratings are integers
+// separated by spaces and may be empty. Empty lines are skipped.
+struct LoadOptions {
+    // tokenizing threads, 0 means one per hardware thread
+    size_t worker_count = 0;
+    // chunks waiting between two stages
+    size_t queue_capacity = 8;
+    // bytes read from the input at once; a longer line grows its chunk
+    size_t chunk_size = 1 << 20;
+};
+
+// Streams documents into the server in three stages: the reader cuts the
+// input into chunks of whole lines, workers tokenize chunks in parallel
+// (SearchServer::ParseDocument), and the calling thread adds them in input
+// order. Words stay views into their chunk until AddDocument interns them,
+// so the corpus is never held in memory as a whole.
+// Returns the number of documents added. The first bad line stops loading
+// with std::invalid_argument naming the line; documents before it stay added.
+size_t LoadDocuments(SearchServer& search_server, std::istream& input, const LoadOptions& options = {});
+size_t LoadDocuments(SearchServer& search_server, const std::string& path, const LoadOptions& options = {});
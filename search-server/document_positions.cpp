@@ -0,0 +1,47 @@
+#include <algorithm>
+#include "document_positions.h"
+
+DocumentPositions::DocumentPositions(const allocator_type& allocator)
+        : words_(allocator)
+        , offsets_(1, 0, allocator)
+        , data_(allocator) {}
+
+void DocumentPositions::Append(const std::string_view word, const std::vector<uint32_t>& positions) {
+    words_.push_back(word);
+    uint32_t previous = 0;
+    for (const uint32_t position : positions) {
+        // 7 bits per byte, the high bit marks that more bytes follow
+        uint32_t delta = position - previous;
+        previous = position;
+        while (delta >= 0x80) {
+            data_.push_back(static_cast<uint8_t>(delta | 0x80));
+            delta >>= 7;
+        }
+        data_.push_back(static_cast<uint8_t>(delta));
+    }
+    offsets_.push_back(static_cast<uint32_t>(data_.size()));
+}
+
+std::vector<uint32_t> DocumentPositions::Positions(const std::string_view word) const {
+    std::vector<uint32_t> positions;
+    const auto iter = std::lower_bound(words_.begin(), words_.end(), word);
+    if (iter == words_.end() || *iter != word) {
+        return positions;
+    }
+    const size_t index = iter - words_.begin();
+    uint32_t position = 0;
+    uint32_t delta = 0;
+    int shift = 0;
+    for (uint32_t i = offsets_[index]; i < offsets_[index + 1]; ++i) {
+        delta |= static_cast<uint32_t>(data_[i] & 0x7F) << shift;
+        if (data_[i] & 0x80) {
+            shift += 7;
+            continue;
+        }
+        position += delta;
+        positions.push_back(position);
+        delta = 0;
+        shift = 0;
+    }
+    return positions;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "counting_allocator.h"
+
+// Word positions of one document. Words are kept sorted; the positions of
+// each word are stored as varint-encoded deltas in one shared byte buffer,
+// so a typical position costs a single byte.
+class DocumentPositions {
+public:
+    using allocator_type = CountingAllocator<char>;
+
+    explicit DocumentPositions(const allocator_type& allocator);
+
+    // words must be appended in ascending order, positions ascending per word
+    void Append(std::string_view word, const std::vector<uint32_t>& positions);
+    // empty if the document has no such word
+    std::vector<uint32_t> Positions(std::string_view word) const;
+
+private:
+    CountedVector<std::string_view> words_;
+    // positions of words_[i] are data_[offsets_[i], offsets_[i + 1])
+    CountedVector<uint32_t> offsets_;
+    CountedVector<uint8_t> data_;
+};
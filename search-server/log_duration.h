@@ -6,6 +6,7 @@
 #define PROFILE_CONCAT(X, Y) PROFILE_CONCAT_INTERNAL(X, Y)
 #define UNIQUE_VAR_NAME_PROFILE(x, y) PROFILE_CONCAT(profileGuard, __LINE__)(x, y)
 #define LOG_DURATION_STREAM(x, y) LogDuration UNIQUE_VAR_NAME_PROFILE(x, y)
+#define LOG_DURATION(x) LogDuration PROFILE_CONCAT(profileGuard, __LINE__)(x)
 
 class LogDuration {
 public:
@@ -30,4 +31,27 @@ private:
     const std::string id_;
     std::ostream& out_;
     const Clock::time_point start_time_ = Clock::now();
-};
\ No newline at end of file
+};
+
+// Same scope-guard idea as LogDuration, but hands the elapsed nanoseconds
+// to a sink (anything with Record(Key, std::chrono::nanoseconds)) instead of printing
+template <typename Sink, typename Key>
+class ScopedDuration {
+public:
+    using Clock = LogDuration::Clock;
+
+    ScopedDuration(Sink& sink, Key key)
+    : sink_(sink),
+    key_(key)
+    {
+    }
+
+    ~ScopedDuration() {
+        sink_.Record(key_, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_time_));
+    }
+
+private:
+    Sink& sink_;
+    const Key key_;
+    const Clock::time_point start_time_ = Clock::now();
+};
@@ -1,72 +1,109 @@
-#include "search_server.h"
-#include "log_duration.h"
-#include <execution>
+#include <fstream>
 #include <iostream>
-#include <random>
 #include <string>
-#include <vector>
-#include "process_queries.h"
+#include "benchmark.h"
+#include "document_loader.h"
+#include "mapped_index.h"
 using namespace std;
-string GenerateWord(mt19937& generator, int max_length) {
-    const int length = uniform_int_distribution(1, max_length)(generator);
-    string word;
-    word.reserve(length);
-    for (int i = 0; i < length; ++i) {
-        word.push_back(uniform_int_distribution('a', 'z')(generator));
-    }
-    return word;
-}
-vector<string> GenerateDictionary(mt19937& generator, int word_count, int max_length) {
-    vector<string> words;
-    words.reserve(word_count);
-    for (int i = 0; i < word_count; ++i) {
-        words.push_back(GenerateWord(generator, max_length));
+
+// usage: search-server [--documents=N] [--dictionary=N] [--word-length=N] [--document-words=N]
+//                      [--queries=N] [--query-words=N] [--minus-prob=P] [--repetitions=N]
+//                      [--seed=N] [--format=json|csv] [--output=FILE]
+//        search-server --convert=CORPUS (--index=FILE | --shm=NAME) [--stop-words=WORDS]
+//                      [--scoring=tfidf|bm25]
+// The second form loads a corpus (see document_loader.h) and writes it as a
+// read-only index for MappedIndex instead of running the benchmarks.
+int main(int argc, char* argv[]) {
+    BenchmarkConfig config;
+    BenchmarkFormat format = BenchmarkFormat::JSON;
+    string output_path;
+    string corpus_path;
+    string index_path;
+    string shm_name;
+    string stop_words;
+    IndexOptions index_options;
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg = argv[i];
+        const size_t eq = arg.find('=');
+        if (arg.substr(0, 2) != "--"sv || eq == arg.npos) {
+            cerr << "Invalid argument "s << arg << endl;
+            return 1;
+        }
+        const string key(arg.substr(2, eq - 2));
+        const string value(arg.substr(eq + 1));
+        try {
+            if (key == "documents"s) {
+                config.document_count = stoi(value);
+            } else if (key == "dictionary"s) {
+                config.dictionary_size = stoi(value);
+            } else if (key == "word-length"s) {
+                config.max_word_length = stoi(value);
+            } else if (key == "document-words"s) {
+                config.document_word_count = stoi(value);
+            } else if (key == "queries"s) {
+                config.query_count = stoi(value);
+            } else if (key == "query-words"s) {
+                config.query_word_count = stoi(value);
+            } else if (key == "minus-prob"s) {
+                config.minus_prob = stod(value);
+            } else if (key == "repetitions"s) {
+                config.repetitions = stoi(value);
+            } else if (key == "seed"s) {
+                config.seed = static_cast<unsigned int>(stoul(value));
+            } else if (key == "format"s && (value == "json"s || value == "csv"s)) {
+                format = value == "csv"s ? BenchmarkFormat::CSV : BenchmarkFormat::JSON;
+            } else if (key == "output"s) {
+                output_path = value;
+            } else if (key == "convert"s) {
+                corpus_path = value;
+            } else if (key == "index"s) {
+                index_path = value;
+            } else if (key == "shm"s) {
+                shm_name = value;
+            } else if (key == "stop-words"s) {
+                stop_words = value;
+            } else if (key == "scoring"s && (value == "tfidf"s || value == "bm25"s)) {
+                index_options.scoring = value == "bm25"s ? Scoring::BM25 : Scoring::TF_IDF;
+            } else {
+                cerr << "Unknown argument "s << arg << endl;
+                return 1;
+            }
+        } catch (const logic_error&) {
+            cerr << "Invalid value in "s << arg << endl;
+            return 1;
+        }
     }
-    words.erase(unique(words.begin(), words.end()), words.end());
-    return words;
-}
-string GenerateQuery(mt19937& generator, const vector<string>& dictionary, int word_count, double minus_prob = 0) {
-    string query;
-    for (int i = 0; i < word_count; ++i) {
-        if (!query.empty()) {
-            query.push_back(' ');
+    if (!corpus_path.empty()) {
+        if (index_path.empty() == shm_name.empty()) {
+            cerr << "Exactly one of --index and --shm is needed with --convert"s << endl;
+            return 1;
         }
-        if (uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
-            query.push_back('-');
+        try {
+            SearchServer search_server(stop_words, index_options);
+            const size_t document_count = LoadDocuments(search_server, corpus_path);
+            if (index_path.empty()) {
+                SaveIndexToSharedMemory(search_server, shm_name);
+            } else {
+                SaveIndex(search_server, index_path);
+            }
+            cout << "Converted "s << document_count << " documents"s << endl;
+        } catch (const exception& e) {
+            cerr << e.what() << endl;
+            return 1;
         }
-        query += dictionary[uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+        return 0;
     }
-    return query;
-}
-vector<string> GenerateQueries(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count) {
-    vector<string> queries;
-    queries.reserve(query_count);
-    for (int i = 0; i < query_count; ++i) {
-        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+    if (config.document_count <= 0 || config.dictionary_size <= 0 || config.max_word_length <= 0
+        || config.query_count <= 0 || config.repetitions <= 0) {
+        cerr << "Counts must be positive"s << endl;
+        return 1;
     }
-    return queries;
-}
-template <typename ExecutionPolicy>
-void Test(string_view mark, const SearchServer& search_server, const vector<string>& queries, ExecutionPolicy&& policy) {
-    LOG_DURATION(mark);
-    double total_relevance = 0;
-    for (const string_view query : queries) {
-        for (const auto& document : search_server.FindTopDocuments(policy, query)) {
-            total_relevance += document.relevance;
-        }
+
+    const auto results = RunBenchmarks(config);
+    if (output_path.empty()) {
+        PrintBenchmarkResults(cout, config, results, format);
+    } else {
+        ofstream out(output_path);
+        PrintBenchmarkResults(out, config, results, format);
     }
-    cout << total_relevance << endl;
 }
-#define TEST(policy) Test(#policy, search_server, queries, execution::policy)
-int main() {
-    mt19937 generator;
-    const auto dictionary = GenerateDictionary(generator, 1000, 10);
-    const auto documents = GenerateQueries(generator, dictionary, 10'000, 70);
-    SearchServer search_server(dictionary[0]);
-    for (size_t i = 0; i < documents.size(); ++i) {
-        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
-    }
-    const auto queries = GenerateQueries(generator, dictionary, 10, 70);
-    TEST(seq);
-    TEST(par);
-}
\ No newline at end of file
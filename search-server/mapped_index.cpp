@@ -0,0 +1,607 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mapped_index.h"
+#include "score_kernel.h"
+#include "string_processing.h"
+
+using namespace std::string_literals;
+using namespace std::string_view_literals;
+
+namespace {
+
+const char INDEX_MAGIC[8] = {'S', 'R', 'C', 'H', 'I', 'D', 'X', '1'};
+const uint32_t INDEX_VERSION = 1;
+// every section starts at a multiple of this
+const size_t SECTION_ALIGNMENT = 8;
+
+size_t AlignSection(size_t offset) {
+    return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+// writes the magic last, so a reader that opens the image early fails the
+// magic check instead of reading a half-written image
+bool WriteImage(int fd, const std::string& image) {
+    const auto write_range = [&](size_t first, size_t last) {
+        while (first < last) {
+            const ssize_t count = pwrite(fd, image.data() + first, last - first, static_cast<off_t>(first));
+            if (count <= 0) {
+                return false;
+            }
+            first += static_cast<size_t>(count);
+        }
+        return true;
+    };
+    return write_range(sizeof(INDEX_MAGIC), image.size()) && write_range(0, sizeof(INDEX_MAGIC));
+}
+
+}  // namespace
+
+// All offsets count bytes from the start of the image; the *_count fields
+// give the number of records of each section.
+struct MappedIndex::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t scoring;
+    double bm25_k1;
+    double bm25_b;
+    uint64_t document_count;
+    uint64_t word_count;
+    uint64_t posting_count;
+    uint64_t stop_word_count;
+    uint64_t total_document_length;
+    uint64_t documents_offset;
+    uint64_t words_offset;
+    uint64_t posting_documents_offset;
+    uint64_t posting_freqs_offset;
+    uint64_t posting_lengths_offset;
+    uint64_t stop_words_offset;
+    uint64_t text_offset;
+    uint64_t text_size;
+    uint64_t file_size;
+};
+
+// sorted by id, postings refer to documents by their index here
+struct MappedIndex::DocumentRecord {
+    int32_t id;
+    int32_t rating;
+    uint32_t status;
+    uint32_t length;
+};
+
+// a string of the text section
+struct MappedIndex::TextRecord {
+    uint64_t offset;
+    uint32_t size;
+    uint32_t reserved;
+};
+
+// sorted by text; the postings of status s are the entries
+// [postings[s], postings[s + 1]) of the three posting arrays,
+// each partition sorted by document index
+struct MappedIndex::WordRecord {
+    TextRecord text;
+    uint64_t postings[STATUS_COUNT + 1];
+};
+
+// sections in order: header, documents, words, posting document indexes
+// (int32), term frequencies (double), document lengths (uint32), stop words,
+// text of the words and stop words
+std::string BuildIndexImage(const SearchServer& search_server) {
+    using Header = MappedIndex::Header;
+    using DocumentRecord = MappedIndex::DocumentRecord;
+    using WordRecord = MappedIndex::WordRecord;
+    using TextRecord = MappedIndex::TextRecord;
+
+    // the image has no positions and scores in double, so such a server would
+    // answer phrases, proximity and float scores differently from its image
+    const IndexOptions& options = search_server.options_;
+    if (options.store_positions) {
+        throw std::invalid_argument("An index image cannot keep word positions"s);
+    }
+    if (options.score_precision != ScorePrecision::DOUBLE) {
+        throw std::invalid_argument("An index image scores in double precision only"s);
+    }
+
+    std::vector<DocumentRecord> documents;
+    documents.reserve(search_server.documents_.size());
+    for (const auto& [document_id, document_data] : search_server.documents_) {
+        documents.push_back({document_id, document_data.rating,
+                             static_cast<uint32_t>(document_data.status), document_data.length});
+    }
+    const auto document_index = [&](int document_id) {
+        return static_cast<int32_t>(std::lower_bound(documents.begin(), documents.end(), document_id,
+                                                     [](const DocumentRecord& document, int id) {
+                                                         return document.id < id;
+                                                     }) - documents.begin());
+    };
+
+    std::string text;
+    const auto add_text = [&](std::string_view word) {
+        const TextRecord record{text.size(), static_cast<uint32_t>(word.size()), 0};
+        text += word;
+        return record;
+    };
+
+    std::vector<WordRecord> words;
+    std::vector<int32_t> posting_documents;
+    std::vector<double> posting_freqs;
+    std::vector<uint32_t> posting_lengths;
+    for (const auto& [word, word_postings] : search_server.word_to_document_freqs_) {
+        if (word_postings.DocumentCount() == 0) {
+            continue;
+        }
+        WordRecord record{add_text(word), {}};
+        for (int s = 0; s < STATUS_COUNT; ++s) {
+            record.postings[s] = posting_documents.size();
+            const PostingList& postings = word_postings.Partition(s);
+            for (size_t i = 0; i < postings.size(); ++i) {
+                const int document_id = postings.DocumentIds()[i];
+                posting_documents.push_back(document_index(document_id));
+                posting_freqs.push_back(postings.TermFreqs()[i]);
+                posting_lengths.push_back(search_server.documents_.at(document_id).length);
+            }
+        }
+        record.postings[STATUS_COUNT] = posting_documents.size();
+        words.push_back(record);
+    }
+
+    std::vector<TextRecord> stop_words;
+    for (const std::string_view word : search_server.stop_words_.Words()) {
+        stop_words.push_back(add_text(word));
+    }
+
+    Header header{};
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.version = INDEX_VERSION;
+    header.scoring = static_cast<uint32_t>(options.scoring);
+    header.bm25_k1 = options.bm25.k1;
+    header.bm25_b = options.bm25.b;
+    header.document_count = documents.size();
+    header.word_count = words.size();
+    header.posting_count = posting_documents.size();
+    header.stop_word_count = stop_words.size();
+    header.total_document_length = search_server.total_document_length_;
+    size_t offset = AlignSection(sizeof(Header));
+    const auto place = [&](uint64_t& section_offset, size_t size) {
+        section_offset = offset;
+        offset = AlignSection(offset + size);
+    };
+    place(header.documents_offset, documents.size() * sizeof(DocumentRecord));
+    place(header.words_offset, words.size() * sizeof(WordRecord));
+    place(header.posting_documents_offset, posting_documents.size() * sizeof(int32_t));
+    place(header.posting_freqs_offset, posting_freqs.size() * sizeof(double));
+    place(header.posting_lengths_offset, posting_lengths.size() * sizeof(uint32_t));
+    place(header.stop_words_offset, stop_words.size() * sizeof(TextRecord));
+    place(header.text_offset, text.size());
+    header.text_size = text.size();
+    header.file_size = offset;
+
+    std::string image(offset, '\0');
+    const auto copy = [&](uint64_t section_offset, const void* data, size_t size) {
+        if (size > 0) {
+            std::memcpy(image.data() + section_offset, data, size);
+        }
+    };
+    copy(0, &header, sizeof(Header));
+    copy(header.documents_offset, documents.data(), documents.size() * sizeof(DocumentRecord));
+    copy(header.words_offset, words.data(), words.size() * sizeof(WordRecord));
+    copy(header.posting_documents_offset, posting_documents.data(), posting_documents.size() * sizeof(int32_t));
+    copy(header.posting_freqs_offset, posting_freqs.data(), posting_freqs.size() * sizeof(double));
+    copy(header.posting_lengths_offset, posting_lengths.data(), posting_lengths.size() * sizeof(uint32_t));
+    copy(header.stop_words_offset, stop_words.data(), stop_words.size() * sizeof(TextRecord));
+    copy(header.text_offset, text.data(), text.size());
+    return image;
+}
+
+// Readers may have the old image mapped, so a save never writes into it: the
+// new image goes to a fresh file or object that replaces the old name, and
+// existing mappings keep the old one until they are closed.
+void SaveIndex(const SearchServer& search_server, const std::string& path) {
+    const std::string image = BuildIndexImage(search_server);
+    std::string temp_path = path + ".XXXXXX"s;
+    const int fd = mkstemp(temp_path.data());
+    if (fd < 0) {
+        throw std::runtime_error("Cannot create a temporary file next to "s + path);
+    }
+    const bool written = fchmod(fd, 0644) == 0 && WriteImage(fd, image) && fsync(fd) == 0;
+    if (close(fd) != 0 || !written || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        unlink(temp_path.c_str());
+        throw std::runtime_error("Cannot write index to "s + path);
+    }
+}
+
+// shared-memory objects cannot be renamed, so the name is unlinked and
+// created anew; until the image is complete its magic stays zero and
+// OpenSharedMemory rejects it
+void SaveIndexToSharedMemory(const SearchServer& search_server, const std::string& name) {
+    const std::string image = BuildIndexImage(search_server);
+    if (shm_unlink(name.c_str()) != 0 && errno != ENOENT) {
+        throw std::runtime_error("Cannot replace shared memory "s + name);
+    }
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot create shared memory "s + name);
+    }
+    const bool written = ftruncate(fd, static_cast<off_t>(image.size())) == 0 && WriteImage(fd, image);
+    close(fd);
+    if (!written) {
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Cannot write index to shared memory "s + name);
+    }
+}
+
+MappedIndex MappedIndex::OpenFile(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open "s + path);
+    }
+    return MapDescriptor(fd, path);
+}
+
+MappedIndex MappedIndex::OpenSharedMemory(const std::string& name) {
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open shared memory "s + name);
+    }
+    return MapDescriptor(fd, name);
+}
+
+// takes ownership of fd; the mapping stays valid after it is closed
+MappedIndex MappedIndex::MapDescriptor(int fd, const std::string& name) {
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(Header)) {
+        close(fd);
+        throw std::runtime_error(name + " is not a search index"s);
+    }
+    const size_t size = static_cast<size_t>(file_stat.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Cannot map "s + name);
+    }
+    try {
+        return MappedIndex(static_cast<const char*>(data), size);
+    } catch (const std::runtime_error& e) {
+        munmap(data, size);
+        throw std::runtime_error(name + ": "s + e.what());
+    }
+}
+
+// checks that every section lies inside the image, so a damaged file
+// fails here instead of in a query
+MappedIndex::MappedIndex(const char* data, size_t size)
+        : data_(data)
+        , size_(size)
+        , header_(reinterpret_cast<const Header*>(data)) {
+    const Header& header = *header_;
+    if (std::memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("not a search index"s);
+    }
+    if (header.version != INDEX_VERSION || header.file_size != size) {
+        throw std::runtime_error("unsupported or truncated index"s);
+    }
+    const auto section = [&](uint64_t offset, uint64_t count, size_t record_size) {
+        if (offset % SECTION_ALIGNMENT != 0 || offset > size || count > (size - offset) / record_size) {
+            throw std::runtime_error("corrupted index"s);
+        }
+        return data + offset;
+    };
+    documents_ = reinterpret_cast<const DocumentRecord*>(
+            section(header.documents_offset, header.document_count, sizeof(DocumentRecord)));
+    words_ = reinterpret_cast<const WordRecord*>(
+            section(header.words_offset, header.word_count, sizeof(WordRecord)));
+    posting_documents_ = reinterpret_cast<const int32_t*>(
+            section(header.posting_documents_offset, header.posting_count, sizeof(int32_t)));
+    posting_freqs_ = reinterpret_cast<const double*>(
+            section(header.posting_freqs_offset, header.posting_count, sizeof(double)));
+    posting_lengths_ = reinterpret_cast<const uint32_t*>(
+            section(header.posting_lengths_offset, header.posting_count, sizeof(uint32_t)));
+    const auto* stop_words = reinterpret_cast<const TextRecord*>(
+            section(header.stop_words_offset, header.stop_word_count, sizeof(TextRecord)));
+    text_ = section(header.text_offset, header.text_size, 1);
+
+    const auto valid_text = [&](const TextRecord& text) {
+        return text.offset <= header.text_size && text.size <= header.text_size - text.offset;
+    };
+    // queries index WordRecord::postings by status and binary-search the
+    // documents by id, the words by text and each partition by document
+    for (size_t i = 0; i < header.document_count; ++i) {
+        if (documents_[i].status >= STATUS_COUNT || (i > 0 && documents_[i - 1].id >= documents_[i].id)) {
+            throw std::runtime_error("corrupted index"s);
+        }
+    }
+    for (size_t i = 0; i < header.word_count; ++i) {
+        const WordRecord& word = words_[i];
+        if (!valid_text(word.text) || word.postings[STATUS_COUNT] > header.posting_count
+            || !std::is_sorted(std::begin(word.postings), std::end(word.postings))
+            || (i > 0 && WordText(words_[i - 1]) >= WordText(word))) {
+            throw std::runtime_error("corrupted index"s);
+        }
+        for (uint32_t s = 0; s < STATUS_COUNT; ++s) {
+            int64_t previous = -1;
+            for (size_t p = word.postings[s]; p < word.postings[s + 1]; ++p) {
+                const int32_t ordinal = posting_documents_[p];
+                if (ordinal <= previous || static_cast<uint64_t>(ordinal) >= header.document_count
+                    || documents_[ordinal].status != s) {
+                    throw std::runtime_error("corrupted index"s);
+                }
+                previous = ordinal;
+            }
+        }
+    }
+    std::set<std::string, std::less<>> stop_word_set;
+    for (size_t i = 0; i < header.stop_word_count; ++i) {
+        if (!valid_text(stop_words[i])) {
+            throw std::runtime_error("corrupted index"s);
+        }
+        stop_word_set.emplace(text_ + stop_words[i].offset, stop_words[i].size);
+    }
+    stop_words_ = StopWordMatcher(stop_word_set);
+}
+
+MappedIndex::MappedIndex(MappedIndex&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr))
+        , size_(std::exchange(other.size_, 0))
+        , header_(other.header_)
+        , documents_(other.documents_)
+        , words_(other.words_)
+        , posting_documents_(other.posting_documents_)
+        , posting_freqs_(other.posting_freqs_)
+        , posting_lengths_(other.posting_lengths_)
+        , text_(other.text_)
+        , stop_words_(std::move(other.stop_words_)) {}
+
+MappedIndex& MappedIndex::operator=(MappedIndex&& other) noexcept {
+    if (this != &other) {
+        if (data_ != nullptr) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        header_ = other.header_;
+        documents_ = other.documents_;
+        words_ = other.words_;
+        posting_documents_ = other.posting_documents_;
+        posting_freqs_ = other.posting_freqs_;
+        posting_lengths_ = other.posting_lengths_;
+        text_ = other.text_;
+        stop_words_ = std::move(other.stop_words_);
+    }
+    return *this;
+}
+
+MappedIndex::~MappedIndex() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+int MappedIndex::GetDocumentCount() const {
+    return static_cast<int>(header_->document_count);
+}
+
+std::vector<int> MappedIndex::GetDocumentIds() const {
+    std::vector<int> ids;
+    ids.reserve(header_->document_count);
+    for (size_t i = 0; i < header_->document_count; ++i) {
+        ids.push_back(documents_[i].id);
+    }
+    return ids;
+}
+
+std::vector<Document> MappedIndex::FindTopDocuments(const std::string_view raw_query,
+                                                    const DocumentStatus status) const {
+    std::vector<Document> documents;
+    for (const auto& [ordinal, relevance] : ScoreQuery(ParseQuery(raw_query), status)) {
+        documents.push_back({documents_[ordinal].id, relevance, documents_[ordinal].rating});
+    }
+    const size_t top = std::min(documents.size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+    std::partial_sort(documents.begin(), documents.begin() + top, documents.end(), IsRankedHigher);
+    documents.resize(top);
+    return documents;
+}
+
+std::vector<Document> MappedIndex::FindTopDocuments(const std::string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> MappedIndex::MatchDocument(
+        const std::string_view raw_query, int document_id) const {
+    const auto iter = std::lower_bound(documents_, documents_ + header_->document_count, document_id,
+                                       [](const DocumentRecord& document, int id) {
+                                           return document.id < id;
+                                       });
+    if (iter == documents_ + header_->document_count || iter->id != document_id) {
+        throw std::out_of_range("No document with id "s + std::to_string(document_id));
+    }
+    const int32_t ordinal = static_cast<int32_t>(iter - documents_);
+    const DocumentStatus status = static_cast<DocumentStatus>(iter->status);
+    const auto contains = [&](const WordRecord* word) {
+        const int32_t* first = posting_documents_ + word->postings[iter->status];
+        const int32_t* last = posting_documents_ + word->postings[iter->status + 1];
+        return std::binary_search(first, last, ordinal);
+    };
+    const Query query = ExpandQuery(ParseQuery(raw_query), static_cast<int>(iter->status),
+                                    static_cast<int>(iter->status) + 1);
+    std::vector<std::string_view> matched_words;
+    if (std::any_of(query.minus_words.begin(), query.minus_words.end(), contains)) {
+        return {matched_words, status};
+    }
+    for (const WordRecord* word : query.plus_words) {
+        if (contains(word)) {
+            matched_words.push_back(WordText(*word));
+        }
+    }
+    return {matched_words, status};
+}
+
+MappedIndex::MappedDocument MappedIndex::DocumentAt(size_t ordinal) const {
+    const DocumentRecord& document = documents_[ordinal];
+    return {document.id, document.rating, static_cast<DocumentStatus>(document.status)};
+}
+
+std::string_view MappedIndex::WordText(const WordRecord& word) const {
+    return {text_ + word.text.offset, word.text.size};
+}
+
+const MappedIndex::WordRecord* MappedIndex::FindWord(const std::string_view word) const {
+    const WordRecord* last = words_ + header_->word_count;
+    const WordRecord* iter = std::lower_bound(words_, last, word, [&](const WordRecord& record, std::string_view text) {
+        return WordText(record) < text;
+    });
+    return iter != last && WordText(*iter) == word ? iter : nullptr;
+}
+
+// only words of the image can match, so plain words are kept as records
+void MappedIndex::AddQueryWord(const std::string_view text, Query& query) const {
+    const QueryWordSyntax syntax = ParseQueryWordSyntax(text);
+    if (stop_words_.Contains(syntax.word)) {
+        return;
+    }
+    if (syntax.is_pattern) {
+        (syntax.is_minus ? query.minus_patterns : query.plus_patterns).push_back(syntax.word);
+    } else if (const WordRecord* record = FindWord(syntax.word)) {
+        (syntax.is_minus ? query.minus_words : query.plus_words).push_back(record);
+    }
+}
+
+std::vector<const MappedIndex::WordRecord*> MappedIndex::ExpandPattern(const std::string_view pattern, bool is_minus,
+                                                                       int first_status, int last_status) const {
+    const WordRecord* last = words_ + header_->word_count;
+    const WordRecord* first = std::lower_bound(words_, last, WildcardPrefix(pattern),
+                                               [&](const WordRecord& record, std::string_view text) {
+                                                   return WordText(record) < text;
+                                               });
+    std::vector<const WordRecord*> words;
+    ExpandWildcard(pattern, is_minus, first, last,
+                   [&](const WordRecord* record) {
+                       return WordText(*record);
+                   },
+                   [&](const WordRecord* record) {
+                       return record->postings[first_status] != record->postings[last_status];
+                   },
+                   [&](const WordRecord* record) {
+                       words.push_back(record);
+                   });
+    return words;
+}
+
+MappedIndex::Query MappedIndex::ExpandQuery(const Query& query, int first_status, int last_status) const {
+    Query expanded{query.plus_words, query.minus_words, {}, {}};
+    for (const std::string_view pattern : query.plus_patterns) {
+        const auto words = ExpandPattern(pattern, false, first_status, last_status);
+        expanded.plus_words.insert(expanded.plus_words.end(), words.begin(), words.end());
+    }
+    for (const std::string_view pattern : query.minus_patterns) {
+        const auto words = ExpandPattern(pattern, true, first_status, last_status);
+        expanded.minus_words.insert(expanded.minus_words.end(), words.begin(), words.end());
+    }
+    // records are sorted by text, so address order is text order
+    for (auto* words : {&expanded.plus_words, &expanded.minus_words}) {
+        std::sort(words->begin(), words->end());
+        words->erase(std::unique(words->begin(), words->end()), words->end());
+    }
+    return expanded;
+}
+
+MappedIndex::Query MappedIndex::ParseQuery(const std::string_view raw_query) const {
+    Query query;
+    for (const std::string_view word : SplitIntoWords(raw_query)) {
+        AddQueryWord(word, query);
+    }
+    return query;
+}
+
+std::vector<std::pair<int, double>> MappedIndex::ScoreQuery(const Query& query,
+                                                            std::optional<DocumentStatus> status) const {
+    if (static_cast<Scoring>(header_->scoring) == Scoring::BM25) {
+        const double average_length = header_->total_document_length > 0
+                                      ? header_->total_document_length * 1.0 / header_->document_count
+                                      : 1.0;
+        return ScoreQuery(query, status, Bm25Scorer({header_->bm25_k1, header_->bm25_b}, average_length));
+    }
+    return ScoreQuery(query, status, TfIdfScorer());
+}
+
+// the accumulation order of SearchServer::FindAllDocuments (words by posting
+// count in the scanned partitions, then by text, then status partitions), so
+// relevance comes out bit-identical
+template <typename Scorer>
+std::vector<std::pair<int, double>> MappedIndex::ScoreQuery(const Query& parsed_query,
+                                                            std::optional<DocumentStatus> status,
+                                                            const Scorer& scorer) const {
+    const int first_status = status ? static_cast<int>(*status) : 0;
+    const int last_status = status ? first_status + 1 : STATUS_COUNT;
+    const Query query = ExpandQuery(parsed_query, first_status, last_status);
+    const auto scanned_postings = [&](const WordRecord* word) {
+        return word->postings[last_status] - word->postings[first_status];
+    };
+    // the query keeps words in text order, which breaks the ties
+    std::vector<const WordRecord*> plus_words = query.plus_words;
+    std::stable_sort(plus_words.begin(), plus_words.end(), [&](const WordRecord* lhs, const WordRecord* rhs) {
+        return scanned_postings(lhs) < scanned_postings(rhs);
+    });
+    size_t posting_count = 0;
+    for (const WordRecord* word : plus_words) {
+        posting_count += scanned_postings(word);
+    }
+    std::vector<std::pair<int, double>> document_to_relevance;
+    if (posting_count == 0) {
+        return document_to_relevance;
+    }
+
+    const size_t document_count = header_->document_count;
+    const auto for_each_posting = [&](const WordRecord* word, auto func) {
+        const double weight = scorer.Weight(document_count, word->postings[STATUS_COUNT] - word->postings[0]);
+        for (size_t i = word->postings[first_status]; i < word->postings[last_status]; ++i) {
+            func(posting_documents_[i], scorer.Score(weight, posting_freqs_[i], posting_lengths_[i]));
+        }
+    };
+    if (document_count <= DENSE_SCORE_RATIO * posting_count) {
+        // -0.0 marks an untouched slot, see score_kernel.h, and -infinity
+        // an excluded one
+        std::vector<double> scores(document_count, -0.0);
+        for (const WordRecord* word : query.minus_words) {
+            for (size_t i = word->postings[first_status]; i < word->postings[last_status]; ++i) {
+                scores[posting_documents_[i]] = -std::numeric_limits<double>::infinity();
+            }
+        }
+        for (const WordRecord* word : plus_words) {
+            if constexpr (Scorer::NEEDS_LENGTHS) {
+                for_each_posting(word, [&](int32_t ordinal, double score) {
+                    scores[ordinal] += score;
+                });
+            } else {
+                const size_t first = word->postings[first_status];
+                const double weight = scorer.Weight(document_count, word->postings[STATUS_COUNT] - word->postings[0]);
+                AccumulateScores(posting_documents_ + first, posting_freqs_ + first,
+                                 word->postings[last_status] - first, weight, 0, scores.data());
+            }
+        }
+        CollectScores(scores.data(), document_count, 0, document_to_relevance);
+    } else {
+        std::map<int, double> relevance_map;
+        for (const WordRecord* word : plus_words) {
+            for_each_posting(word, [&](int32_t ordinal, double score) {
+                relevance_map[ordinal] += score;
+            });
+        }
+        for (const WordRecord* word : query.minus_words) {
+            for (size_t i = word->postings[first_status]; i < word->postings[last_status]; ++i) {
+                relevance_map.erase(posting_documents_[i]);
+            }
+        }
+        document_to_relevance.assign(relevance_map.begin(), relevance_map.end());
+    }
+    return document_to_relevance;
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "document.h"
+#include "scoring.h"
+#include "search_server.h"
+#include "stop_word_matcher.h"
+
+// Read-only index for serving from several processes at once. Every
+// reference inside the image is an offset from its start, so a file or a
+// POSIX shared-memory segment can be mapped at any address and the page
+// cache keeps one copy for all the processes. Postings refer to documents
+// by their position in the id-sorted document table. The image uses the
+// native byte order and is read on the machine type that wrote it.
+
+// the server must not be modified while its image is built; servers with
+// IndexOptions::store_positions or float scores throw std::invalid_argument,
+// since the image could not answer their queries the same way
+std::string BuildIndexImage(const SearchServer& search_server);
+void SaveIndex(const SearchServer& search_server, const std::string& path);
+// name as for shm_open, e.g. "/search-index"
+void SaveIndexToSharedMemory(const SearchServer& search_server, const std::string& name);
+
+// Answers queries like SearchServer (plus and minus words, stop words,
+// wildcards, the server's scoring) straight from the mapping, with the same
+// results. Phrase queries need positions, which the image does not keep.
+class MappedIndex {
+public:
+    struct MappedDocument {
+        int id;
+        int rating;
+        DocumentStatus status;
+    };
+
+    static MappedIndex OpenFile(const std::string& path);
+    static MappedIndex OpenSharedMemory(const std::string& name);
+
+    MappedIndex(MappedIndex&& other) noexcept;
+    MappedIndex& operator=(MappedIndex&& other) noexcept;
+    MappedIndex(const MappedIndex&) = delete;
+    MappedIndex& operator=(const MappedIndex&) = delete;
+    ~MappedIndex();
+
+    int GetDocumentCount() const;
+    std::vector<int> GetDocumentIds() const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    // the words point into the mapping and live as long as this object
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query,
+                                                                            int document_id) const;
+
+private:
+    friend std::string BuildIndexImage(const SearchServer& search_server);
+
+    struct Header;
+    struct DocumentRecord;
+    struct WordRecord;
+    struct TextRecord;
+
+    struct Query {
+        std::vector<const WordRecord*> plus_words;
+        std::vector<const WordRecord*> minus_words;
+        // wildcard words, expanded by ExpandQuery
+        std::vector<std::string_view> plus_patterns;
+        std::vector<std::string_view> minus_patterns;
+    };
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    const Header* header_ = nullptr;
+    const DocumentRecord* documents_ = nullptr;
+    const WordRecord* words_ = nullptr;
+    const int32_t* posting_documents_ = nullptr;
+    const double* posting_freqs_ = nullptr;
+    const uint32_t* posting_lengths_ = nullptr;
+    const char* text_ = nullptr;
+    StopWordMatcher stop_words_;
+
+    MappedIndex(const char* data, size_t size);
+    static MappedIndex MapDescriptor(int fd, const std::string& name);
+
+    MappedDocument DocumentAt(size_t ordinal) const;
+    std::string_view WordText(const WordRecord& word) const;
+    const WordRecord* FindWord(std::string_view word) const;
+    void AddQueryWord(std::string_view text, Query& query) const;
+    Query ParseQuery(std::string_view raw_query) const;
+    std::vector<const WordRecord*> ExpandPattern(std::string_view pattern, bool is_minus, int first_status,
+                                                 int last_status) const;
+    // the query's words and the expansions of its patterns over the statuses
+    // [first_status, last_status), as SearchServer::PlanQuery expands them
+    Query ExpandQuery(const Query& query, int first_status, int last_status) const;
+    // ordinals of the matching documents with their relevance, ascending
+    std::vector<std::pair<int, double>> ScoreQuery(const Query& query, std::optional<DocumentStatus> status) const;
+    template <typename Scorer>
+    std::vector<std::pair<int, double>> ScoreQuery(const Query& query, std::optional<DocumentStatus> status,
+                                                   const Scorer& scorer) const;
+};
+
+template <typename DocumentPredicate>
+std::vector<Document> MappedIndex::FindTopDocuments(const std::string_view raw_query,
+                                                    DocumentPredicate document_predicate) const {
+    std::vector<Document> documents;
+    for (const auto& [ordinal, relevance] : ScoreQuery(ParseQuery(raw_query), std::nullopt)) {
+        const MappedDocument document = DocumentAt(ordinal);
+        if (document_predicate(document.id, document.status, document.rating)) {
+            documents.push_back({document.id, relevance, document.rating});
+        }
+    }
+    const size_t top = std::min(documents.size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+    std::partial_sort(documents.begin(), documents.begin() + top, documents.end(), IsRankedHigher);
+    documents.resize(top);
+    return documents;
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include <iterator>
+#include <stdexcept>
 #include "document.h"
 #include "search_server.h"
 
@@ -36,34 +38,82 @@ std::ostream& operator<<(std::ostream& out, const IteratorRange<Iterator>& range
     return out;
 }
 
+// Pages are built on the fly while iterating, nothing is stored up front
 template <typename Iterator>
 class Paginator {
 public:
-    Paginator(Iterator begin, Iterator end, size_t page_size) {
-        for (size_t left = distance(begin, end); left > 0;) {
-            const size_t current_page_size = std::min(page_size, left);
-            const Iterator current_page_end = next(begin, current_page_size);
-            pages_.push_back({begin, current_page_end});
-
-            left -= current_page_size;
-            begin = current_page_end;
+    class PageIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = IteratorRange<Iterator>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = IteratorRange<Iterator>;
+
+        PageIterator(Iterator first, size_t left, size_t page_size)
+                : first_(first)
+                , left_(left)
+                , page_size_(page_size) {
+        }
+
+        IteratorRange<Iterator> operator*() const {
+            return {first_, next(first_, std::min(page_size_, left_))};
+        }
+
+        PageIterator& operator++() {
+            const size_t step = std::min(page_size_, left_);
+            first_ = next(first_, step);
+            left_ -= step;
+            return *this;
+        }
+
+        PageIterator operator++(int) {
+            PageIterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const PageIterator& other) const {
+            return left_ == other.left_;
+        }
+
+        bool operator!=(const PageIterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        Iterator first_;
+        size_t left_;
+        size_t page_size_;
+    };
+
+    Paginator(Iterator begin, Iterator end, size_t page_size)
+            : begin_(begin)
+            , end_(end)
+            , size_(distance(begin, end))
+            , page_size_(page_size) {
+        using std::string_literals::operator""s;
+        if (page_size == 0) {
+            throw std::invalid_argument("Page size must be positive"s);
         }
     }
 
-    auto begin() const {
-        return pages_.begin();
+    PageIterator begin() const {
+        return {begin_, size_, page_size_};
     }
 
-    auto end() const {
-        return pages_.end();
+    PageIterator end() const {
+        return {end_, 0, page_size_};
     }
 
     size_t size() const {
-        return pages_.size();
+        return (size_ + page_size_ - 1) / page_size_;
     }
 
 private:
-    std::vector<IteratorRange<Iterator>> pages_;
+    Iterator begin_, end_;
+    size_t size_;
+    size_t page_size_;
 };
 
 template <typename Container>
@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <stdexcept>
+#include "posting_list.h"
+
+using std::string_literals::operator""s;
+
+PostingList::PostingList(const allocator_type& allocator, bool store_lengths)
+        : document_ids_(allocator)
+        , term_freqs_(allocator)
+        , document_lengths_(allocator)
+        , store_lengths_(store_lengths) {}
+
+void PostingList::Insert(int document_id, double term_freq, uint32_t document_length) {
+    if (document_ids_.empty() || document_ids_.back() < document_id) {
+        document_ids_.push_back(document_id);
+        term_freqs_.push_back(term_freq);
+        if (store_lengths_) {
+            document_lengths_.push_back(document_length);
+        }
+        return;
+    }
+    const size_t pos = LowerBound(document_id);
+    if (document_ids_[pos] == document_id) {
+        term_freqs_[pos] += term_freq;
+        return;
+    }
+    document_ids_.insert(document_ids_.begin() + pos, document_id);
+    term_freqs_.insert(term_freqs_.begin() + pos, term_freq);
+    if (store_lengths_) {
+        document_lengths_.insert(document_lengths_.begin() + pos, document_length);
+    }
+}
+
+bool PostingList::Erase(int document_id) {
+    const size_t pos = LowerBound(document_id);
+    if (pos == document_ids_.size() || document_ids_[pos] != document_id) {
+        return false;
+    }
+    document_ids_.erase(document_ids_.begin() + pos);
+    term_freqs_.erase(term_freqs_.begin() + pos);
+    if (store_lengths_) {
+        document_lengths_.erase(document_lengths_.begin() + pos);
+    }
+    return true;
+}
+
+double PostingList::Extract(int document_id) {
+    const double term_freq = TermFreq(document_id);
+    Erase(document_id);
+    return term_freq;
+}
+
+bool PostingList::Contains(int document_id) const {
+    const size_t pos = LowerBound(document_id);
+    return pos < document_ids_.size() && document_ids_[pos] == document_id;
+}
+
+double PostingList::TermFreq(int document_id) const {
+    const size_t pos = LowerBound(document_id);
+    if (pos == document_ids_.size() || document_ids_[pos] != document_id) {
+        throw std::out_of_range("No posting for document "s + std::to_string(document_id));
+    }
+    return term_freqs_[pos];
+}
+
+size_t PostingList::LowerBound(int document_id) const {
+    return std::lower_bound(document_ids_.begin(), document_ids_.end(), document_id) - document_ids_.begin();
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "counting_allocator.h"
+
+// Postings of one word as two parallel arrays sorted by document id.
+// New documents usually come with growing ids, so Insert is an append
+// in the common case; inserting or erasing in the middle shifts the tail.
+// Scorers that normalise by document length can ask for a third array
+// holding the length of each posting's document.
+class PostingList {
+public:
+    using allocator_type = CountingAllocator<int>;
+
+    explicit PostingList(const allocator_type& allocator, bool store_lengths = false);
+
+    // document_length is kept only by a list that stores lengths
+    void Insert(int document_id, double term_freq, uint32_t document_length = 0);
+    bool Erase(int document_id);
+    // removes the posting and returns its term frequency, the posting must exist
+    double Extract(int document_id);
+
+    bool Contains(int document_id) const;
+    // the posting must exist
+    double TermFreq(int document_id) const;
+
+    size_t size() const {
+        return document_ids_.size();
+    }
+    bool empty() const {
+        return document_ids_.empty();
+    }
+    const CountedVector<int>& DocumentIds() const {
+        return document_ids_;
+    }
+    const CountedVector<double>& TermFreqs() const {
+        return term_freqs_;
+    }
+    // empty unless the list stores lengths
+    const CountedVector<uint32_t>& DocumentLengths() const {
+        return document_lengths_;
+    }
+    bool StoresLengths() const {
+        return store_lengths_;
+    }
+    allocator_type get_allocator() const {
+        return document_ids_.get_allocator();
+    }
+
+private:
+    CountedVector<int> document_ids_;
+    CountedVector<double> term_freqs_;
+    CountedVector<uint32_t> document_lengths_;
+    bool store_lengths_;
+
+    size_t LowerBound(int document_id) const;
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+// check the control every this many postings inside the scoring loop
+const int CANCELLATION_CHECK_INTERVAL = 4096;
+
+class QueryCancelled : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Shared between the caller and a running query: the query gives up with
+// QueryCancelled once Cancel() is called or the deadline has passed.
+class QueryControl {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit QueryControl(Clock::time_point deadline = Clock::time_point::max())
+            : deadline_(deadline) {}
+
+    void Cancel() {
+        cancelled_.store(true, std::memory_order_relaxed);
+    }
+
+    void ThrowIfCancelled() const {
+        using std::string_literals::operator""s;
+        if (cancelled_.load(std::memory_order_relaxed)) {
+            throw QueryCancelled("Query cancelled"s);
+        }
+        if (Clock::now() >= deadline_) {
+            throw QueryCancelled("Query deadline exceeded"s);
+        }
+    }
+
+private:
+    std::atomic<bool> cancelled_{false};
+    const Clock::time_point deadline_;
+};
+
+// An exception escaping a parallel algorithm calls std::terminate, so the
+// tasks of a cancellable parallel loop run their body through Run, which
+// keeps the first QueryCancelled; Rethrow raises it after the loop. The
+// other tasks share the control and stop at their own next check.
+class ParallelCancellation {
+public:
+    template <typename Func>
+    void Run(Func func) {
+        try {
+            func();
+        } catch (const QueryCancelled&) {
+            std::lock_guard guard(mutex_);
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+        }
+    }
+
+    void Rethrow() const {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::exception_ptr error_;
+};
@@ -0,0 +1,35 @@
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include "query_parsing.h"
+
+using std::string_literals::operator""s;
+using std::string_view_literals::operator""sv;
+
+QueryWordSyntax ParseQueryWordSyntax(const std::string_view text) {
+    if (text.empty()) {
+        throw std::invalid_argument("Query word is empty"s);
+    }
+    std::string_view word = text;
+    bool is_minus = false;
+    if (word[0] == '-') {
+        is_minus = true;
+        word = word.substr(1);
+    }
+    if (word.empty() || word[0] == '-' || !IsValidWord(word)) {
+        throw std::invalid_argument("Query word "s + static_cast<std::string>(text) + " is invalid"s);
+    }
+    const size_t wildcard = word.find_first_of("*?"sv);
+    if (wildcard == 0) {
+        throw std::invalid_argument("Query word "s + static_cast<std::string>(text) + " must not start with a wildcard"s);
+    }
+    return {word, is_minus, wildcard != word.npos};
+}
+
+std::string_view WildcardPrefix(const std::string_view pattern) {
+    return pattern.substr(0, pattern.find_first_of("*?"sv));
+}
+
+size_t MaxExpandedTerms(bool is_minus) {
+    return is_minus ? std::numeric_limits<size_t>::max() : MAX_EXPANDED_TERMS;
+}
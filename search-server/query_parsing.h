@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include "string_processing.h"
+
+// Query syntax shared by SearchServer and MappedIndex, so both engines read
+// a query and expand its wildcards the same way.
+
+// a wildcard plus word stands for at most this many indexed words with
+// postings in the searched statuses; a wildcard minus word is not capped
+const size_t MAX_EXPANDED_TERMS = 64;
+
+// one word of a raw query
+struct QueryWordSyntax {
+    std::string_view word;   // without the minus sign
+    bool is_minus;
+    bool is_pattern;         // holds '*' or '?'
+};
+
+// throws std::invalid_argument for an empty word, a bare or doubled minus,
+// control characters and a pattern starting with a wildcard
+QueryWordSyntax ParseQueryWordSyntax(std::string_view text);
+
+// the literal characters before the first wildcard
+std::string_view WildcardPrefix(std::string_view pattern);
+size_t MaxExpandedTerms(bool is_minus);
+
+// Calls add(iter) for each entry of a sorted word range that matches the
+// pattern and has postings in the searched statuses, in range order and at
+// most MaxExpandedTerms(is_minus) times. first must be the first entry not
+// less than WildcardPrefix(pattern); the scan stops where the prefix ends.
+template <typename Iterator, typename WordOf, typename HasPostings, typename Add>
+void ExpandWildcard(std::string_view pattern, bool is_minus, Iterator first, Iterator last,
+                    WordOf word_of, HasPostings has_postings, Add add) {
+    const std::string_view prefix = WildcardPrefix(pattern);
+    const size_t max_count = MaxExpandedTerms(is_minus);
+    for (size_t count = 0; first != last && count < max_count; ++first) {
+        const std::string_view word = word_of(first);
+        if (word.substr(0, prefix.size()) != prefix) {
+            break;
+        }
+        if (has_postings(first) && MatchesWildcard(pattern, word)) {
+            add(first);
+            ++count;
+        }
+    }
+}
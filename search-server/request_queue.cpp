@@ -0,0 +1,18 @@
+#include "request_queue.h"
+
+std::vector<Document> RequestQueue::RecordRequest(std::vector<Document> results) {
+    ++current_time_;
+    if (!requests_.empty()) {
+        while(current_time_ - requests_.front().request_time >= min_in_day_) {
+            if (requests_.front().docs == 0){
+                --no_results_;
+            }
+            requests_.pop_front();
+        }
+    }
+    requests_.push_back({static_cast<int>(results.size()), current_time_});
+    if (results.empty()) {
+        ++no_results_;
+    }
+    return results;
+}
@@ -12,26 +12,11 @@ public:
 
     template <typename DocumentPredicate>
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
-        ++current_time_;
-        std::vector<Document> results = server_.FindTopDocuments(raw_query, document_predicate);
-        if (!requests_.empty()) {
-            while(current_time_ - requests_.front().request_time >= min_in_day_) {
-                if (requests_.front().docs == 0){
-                    --no_results_;
-                }
-                requests_.pop_front();
-            }
-        }
-        requests_.push_back({static_cast<int>(results.size()), current_time_});
-        if (results.empty()) {
-            ++no_results_;
-        }
-        return results;
+        return RecordRequest(server_.FindTopDocuments(raw_query, document_predicate));
     }
+    // searches only the status partition instead of filtering every status by a predicate
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentStatus status) {
-        return RequestQueue::AddFindRequest(raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-            return document_status == status;
-        });
+        return RecordRequest(server_.FindTopDocuments(raw_query, status));
     }
 
     std::vector<Document> AddFindRequest(const std::string& raw_query) {
@@ -51,4 +36,6 @@ private:
     const SearchServer& server_;
     int no_results_;
     int current_time_;
+
+    std::vector<Document> RecordRequest(std::vector<Document> results);
 };
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include <cmath>
+#include "score_kernel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCORE_KERNEL_AVX2
+#include <immintrin.h>
+#endif
+
+namespace {
+
+template <typename Score>
+void AccumulateScalar(const int* document_ids, const double* term_freqs, size_t count,
+                      double inverse_document_freq, int base, Score* scores) {
+    for (size_t i = 0; i < count; ++i) {
+        scores[document_ids[i] - base] += static_cast<Score>(term_freqs[i] * inverse_document_freq);
+    }
+}
+
+template <typename Score>
+void CollectScalar(const Score* scores, size_t count, int base, std::vector<std::pair<int, double>>& result) {
+    for (size_t i = 0; i < count; ++i) {
+        if (!std::signbit(scores[i])) {
+            result.emplace_back(base + static_cast<int>(i), scores[i]);
+        }
+    }
+}
+
+#ifdef SCORE_KERNEL_AVX2
+// AVX2 gathers the old scores but has no scatter, so the sums are stored lane by lane
+
+__attribute__((target("avx2")))
+void AccumulateAvx2(const int* document_ids, const double* term_freqs, size_t count,
+                    double inverse_document_freq, int base, double* scores) {
+    const __m256d idf = _mm256_set1_pd(inverse_document_freq);
+    const __m128i offset = _mm_set1_epi32(base);
+    const __m256d all_lanes = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    alignas(16) int slots[4];
+    alignas(32) double sums[4];
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i slot = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(document_ids + i)), offset);
+        const __m256d old = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), scores, slot, all_lanes, 8);
+        const __m256d sum = _mm256_add_pd(old, _mm256_mul_pd(_mm256_loadu_pd(term_freqs + i), idf));
+        _mm_store_si128(reinterpret_cast<__m128i*>(slots), slot);
+        _mm256_store_pd(sums, sum);
+        for (int lane = 0; lane < 4; ++lane) {
+            scores[slots[lane]] = sums[lane];
+        }
+    }
+    AccumulateScalar(document_ids + i, term_freqs + i, count - i, inverse_document_freq, base, scores);
+}
+
+__attribute__((target("avx2")))
+void AccumulateAvx2(const int* document_ids, const double* term_freqs, size_t count,
+                    double inverse_document_freq, int base, float* scores) {
+    const __m256d idf = _mm256_set1_pd(inverse_document_freq);
+    const __m256i offset = _mm256_set1_epi32(base);
+    alignas(32) int slots[8];
+    alignas(32) float sums[8];
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i slot = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(document_ids + i)), offset);
+        const __m256 old = _mm256_i32gather_ps(scores, slot, 4);
+        // products are rounded to float exactly as the scalar kernel does
+        const __m128 low = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_loadu_pd(term_freqs + i), idf));
+        const __m128 high = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_loadu_pd(term_freqs + i + 4), idf));
+        const __m256 sum = _mm256_add_ps(old, _mm256_set_m128(high, low));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(slots), slot);
+        _mm256_store_ps(sums, sum);
+        for (int lane = 0; lane < 8; ++lane) {
+            scores[slots[lane]] = sums[lane];
+        }
+    }
+    AccumulateScalar(document_ids + i, term_freqs + i, count - i, inverse_document_freq, base, scores);
+}
+
+// whole vectors of untouched slots are skipped by their sign mask
+__attribute__((target("avx2")))
+void CollectAvx2(const double* scores, size_t count, int base, std::vector<std::pair<int, double>>& result) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const int untouched = _mm256_movemask_pd(_mm256_loadu_pd(scores + i));
+        if (untouched == 0xF) {
+            continue;
+        }
+        for (int lane = 0; lane < 4; ++lane) {
+            if ((untouched & (1 << lane)) == 0) {
+                result.emplace_back(base + static_cast<int>(i) + lane, scores[i + lane]);
+            }
+        }
+    }
+    CollectScalar(scores + i, count - i, base + static_cast<int>(i), result);
+}
+
+__attribute__((target("avx2")))
+void CollectAvx2(const float* scores, size_t count, int base, std::vector<std::pair<int, double>>& result) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int untouched = _mm256_movemask_ps(_mm256_loadu_ps(scores + i));
+        if (untouched == 0xFF) {
+            continue;
+        }
+        for (int lane = 0; lane < 8; ++lane) {
+            if ((untouched & (1 << lane)) == 0) {
+                result.emplace_back(base + static_cast<int>(i) + lane, scores[i + lane]);
+            }
+        }
+    }
+    CollectScalar(scores + i, count - i, base + static_cast<int>(i), result);
+}
+#endif
+
+bool UseAvx2() {
+#ifdef SCORE_KERNEL_AVX2
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+ScoreKernel ActiveScoreKernel() {
+    return UseAvx2() ? ScoreKernel::AVX2 : ScoreKernel::SCALAR;
+}
+
+void AccumulateScores(const int* document_ids, const double* term_freqs, size_t count,
+                      double inverse_document_freq, int base, double* scores) {
+#ifdef SCORE_KERNEL_AVX2
+    if (UseAvx2()) {
+        AccumulateAvx2(document_ids, term_freqs, count, inverse_document_freq, base, scores);
+        return;
+    }
+#endif
+    AccumulateScalar(document_ids, term_freqs, count, inverse_document_freq, base, scores);
+}
+
+void AccumulateScores(const int* document_ids, const double* term_freqs, size_t count,
+                      double inverse_document_freq, int base, float* scores) {
+#ifdef SCORE_KERNEL_AVX2
+    if (UseAvx2()) {
+        AccumulateAvx2(document_ids, term_freqs, count, inverse_document_freq, base, scores);
+        return;
+    }
+#endif
+    AccumulateScalar(document_ids, term_freqs, count, inverse_document_freq, base, scores);
+}
+
+void AccumulateScoresScalar(const int* document_ids, const double* term_freqs, size_t count,
+                            double inverse_document_freq, int base, double* scores) {
+    AccumulateScalar(document_ids, term_freqs, count, inverse_document_freq, base, scores);
+}
+
+void AccumulateScoresScalar(const int* document_ids, const double* term_freqs, size_t count,
+                            double inverse_document_freq, int base, float* scores) {
+    AccumulateScalar(document_ids, term_freqs, count, inverse_document_freq, base, scores);
+}
+
+void CollectScores(const double* scores, size_t count, int base, std::vector<std::pair<int, double>>& result) {
+#ifdef SCORE_KERNEL_AVX2
+    if (UseAvx2()) {
+        CollectAvx2(scores, count, base, result);
+        return;
+    }
+#endif
+    CollectScalar(scores, count, base, result);
+}
+
+void CollectScores(const float* scores, size_t count, int base, std::vector<std::pair<int, double>>& result) {
+#ifdef SCORE_KERNEL_AVX2
+    if (UseAvx2()) {
+        CollectAvx2(scores, count, base, result);
+        return;
+    }
+#endif
+    CollectScalar(scores, count, base, result);
+}
+
+void CollectScoresScalar(const double* scores, size_t count, int base, std::vector<std::pair<int, double>>& result) {
+    CollectScalar(scores, count, base, result);
+}
+
+void CollectScoresScalar(const float* scores, size_t count, int base, std::vector<std::pair<int, double>>& result) {
+    CollectScalar(scores, count, base, result);
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Kernels over a dense score array indexed by document id - base.
+// An untouched slot holds -0.0: term_freq * inverse_document_freq is never
+// negative and -0.0 + x == +0.0 for x == +0.0, so a slot is touched exactly
+// when its sign bit is clear, even if its score stays zero.
+// The AVX2 variants are picked at run time when the CPU supports them;
+// the scalar ones are exported so tests/score_kernel_test.cpp can check
+// the two agree.
+
+enum class ScorePrecision {
+    DOUBLE,
+    FLOAT,   // half the accumulator memory, relevance keeps about 7 significant digits
+};
+
+enum class ScoreKernel {
+    SCALAR,
+    AVX2,
+};
+
+// the kernel AccumulateScores / CollectScores dispatch to on this CPU
+ScoreKernel ActiveScoreKernel();
+
+// scores[document_ids[i] - base] += term_freqs[i] * inverse_document_freq;
+// the ids of one call must be distinct, as in a posting list
+void AccumulateScores(const int* document_ids, const double* term_freqs, size_t count,
+                      double inverse_document_freq, int base, double* scores);
+void AccumulateScores(const int* document_ids, const double* term_freqs, size_t count,
+                      double inverse_document_freq, int base, float* scores);
+void AccumulateScoresScalar(const int* document_ids, const double* term_freqs, size_t count,
+                            double inverse_document_freq, int base, double* scores);
+void AccumulateScoresScalar(const int* document_ids, const double* term_freqs, size_t count,
+                            double inverse_document_freq, int base, float* scores);
+
+// appends {base + i, scores[i]} for every touched slot, in ascending id order
+void CollectScores(const double* scores, size_t count, int base, std::vector<std::pair<int, double>>& result);
+void CollectScores(const float* scores, size_t count, int base, std::vector<std::pair<int, double>>& result);
+void CollectScoresScalar(const double* scores, size_t count, int base, std::vector<std::pair<int, double>>& result);
+void CollectScoresScalar(const float* scores, size_t count, int base, std::vector<std::pair<int, double>>& result);
@@ -0,0 +1,58 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+enum class Scoring {
+    TF_IDF,
+    BM25,
+};
+
+// SearchServer rejects k1 < 0 and b outside [0, 1]
+struct Bm25Parameters {
+    double k1 = 1.2;
+    double b = 0.75;
+};
+
+// Scorers are passed to the search as template arguments, so the posting
+// loop calls them directly. Weight runs once per query word, Score once per
+// posting with the term frequency normalised by document length (as stored
+// in PostingList) and the document length itself when NEEDS_LENGTHS is set.
+
+class TfIdfScorer {
+public:
+    static constexpr bool NEEDS_LENGTHS = false;
+
+    double Weight(size_t document_count, size_t word_document_count) const {
+        return std::log(document_count * 1.0 / word_document_count);
+    }
+
+    double Score(double weight, double term_freq, uint32_t) const {
+        return term_freq * weight;
+    }
+};
+
+class Bm25Scorer {
+public:
+    static constexpr bool NEEDS_LENGTHS = true;
+
+    Bm25Scorer(const Bm25Parameters& parameters, double average_length)
+            : k1_(parameters.k1)
+            , constant_norm_(parameters.k1 * (1.0 - parameters.b))
+            , length_norm_(parameters.k1 * parameters.b / average_length) {}
+
+    double Weight(size_t document_count, size_t word_document_count) const {
+        return std::log(1.0 + (document_count - word_document_count + 0.5) / (word_document_count + 0.5));
+    }
+
+    double Score(double weight, double term_freq, uint32_t document_length) const {
+        const double count = term_freq * document_length;
+        return weight * count * (k1_ + 1.0) / (count + constant_norm_ + length_norm_ * document_length);
+    }
+
+private:
+    double k1_;
+    // k1 * (1 - b + b * length / average_length) split into its two terms
+    double constant_norm_;
+    double length_norm_;
+};
@@ -0,0 +1,66 @@
+#pragma once
+#include <memory>
+#include <optional>
+#include <vector>
+#include "document.h"
+
+// Continuation token: the last document of the previous page.
+// The next page starts right after it in the result order.
+struct PageToken {
+    double relevance = 0.0;
+    int rating = 0;
+    int id = 0;
+};
+
+// Either page number `page` (counted from 0) of `page_size` results,
+// or, when `after` is set, the `page_size` results following that token
+struct PageRequest {
+    size_t page_size = 0;
+    size_t page = 0;
+    std::optional<PageToken> after;
+};
+
+// A view of one page of results. Pages share the query's result buffer,
+// so copying a page copies no documents.
+class SearchPage {
+public:
+    using Iterator = std::vector<Document>::const_iterator;
+
+    SearchPage(std::shared_ptr<const std::vector<Document>> results, size_t first, size_t last,
+               std::optional<PageToken> next_page)
+            : results_(std::move(results))
+            , first_(first)
+            , last_(last)
+            , next_page_(next_page) {}
+
+    Iterator begin() const {
+        return results_->begin() + first_;
+    }
+
+    Iterator end() const {
+        return results_->begin() + last_;
+    }
+
+    size_t size() const {
+        return last_ - first_;
+    }
+
+    bool empty() const {
+        return first_ == last_;
+    }
+
+    const Document& operator[](size_t index) const {
+        return (*results_)[first_ + index];
+    }
+
+    // empty on the last page
+    const std::optional<PageToken>& NextPage() const {
+        return next_page_;
+    }
+
+private:
+    std::shared_ptr<const std::vector<Document>> results_;
+    size_t first_;
+    size_t last_;
+    std::optional<PageToken> next_page_;
+};
@@ -1,49 +1,152 @@
 #include <numeric>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <sstream>
+#include <utility>
 #include "search_server.h"
 
 using std::string_literals::operator""s;
+using std::string_view_literals::operator""sv;
 
-SearchServer::SearchServer(const std::string& stop_words_text)
-        : SearchServer::SearchServer(SplitIntoWords(stop_words_text)) {}
+bool IsRankedHigher(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) < ACCURACY_THRESHOLD) {
+        if (lhs.rating != rhs.rating) {
+            return lhs.rating > rhs.rating;
+        }
+        return lhs.id < rhs.id;
+    }
+    return lhs.relevance > rhs.relevance;
+}
+
+SearchServer::SearchServer(const std::string& stop_words_text, IndexOptions options)
+        : SearchServer::SearchServer(SplitIntoWords(stop_words_text), options) {}
 
-SearchServer::SearchServer(const std::string_view stop_words_text)
-        : SearchServer::SearchServer(SplitIntoWords(stop_words_text)) {}
+SearchServer::SearchServer(const std::string_view stop_words_text, IndexOptions options)
+        : SearchServer::SearchServer(SplitIntoWords(stop_words_text), options) {}
 
 void SearchServer::AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    AddDocument(ParseDocument(document_id, document, status, ratings));
+}
+
+SearchServer::ParsedDocument SearchServer::ParseDocument(int document_id, const std::string_view document,
+                                                         DocumentStatus status, const std::vector<int>& ratings) const {
+    if (document_id < 0) {
+        throw std::invalid_argument("Invalid document_id"s);
+    }
+    ParsedDocument result(document_id, status, ComputeAverageRating(ratings), SplitIntoWordsNoStop(document));
+    // equal words become adjacent runs, so the index is touched once per distinct word
+    std::sort(result.words_.begin(), result.words_.end());
+    if (options_.store_positions) {
+        // positions count every word of the text, stop words included, so a phrase
+        // with a stop word inside matches only the same gap in the document
+        uint32_t position = 0;
+        for (const std::string_view word : SplitIntoWords(document)) {
+            if (!IsStopWord(word)) {
+                result.word_positions_.emplace_back(word, position);
+            }
+            ++position;
+        }
+        std::sort(result.word_positions_.begin(), result.word_positions_.end());
+    }
+    return result;
+}
+
+void SearchServer::AddDocument(ParsedDocument&& document) {
+    SEARCH_STAGE(*stats_, SearchStage::ADD_DOCUMENT);
+    const int document_id = document.id_;
+    const DocumentStatus status = document.status_;
     if ((document_id < 0) || (documents_.count(document_id) > 0)) {
         throw std::invalid_argument("Invalid document_id"s);
     }
-    const auto words = SplitIntoWordsNoStop(document);
+    const auto& words = document.words_;
     const double inv_word_count = 1.0 / words.size();
-    for (const std::string_view word : words) {
-        auto [iter,_] = doc_words_.insert(static_cast<std::string>(word));
-        word_to_document_freqs_[*iter][document_id] += inv_word_count;
-        document_to_word_freqs_[document_id][*iter] += inv_word_count; //new index id->words
+    WordFrequencies* word_freqs = nullptr;
+    CountedVector<std::string_view>* document_words = nullptr;
+    if (options_.compact) {
+        document_words = &document_to_words_.try_emplace(
+                document_id, document_to_words_.get_allocator()).first->second;
+    } else {
+        word_freqs = &document_to_word_freqs_.try_emplace(
+                document_id, document_to_word_freqs_.get_allocator()).first->second;
+    }
+    std::vector<std::string_view> interned_words;
+    for (auto first = words.begin(); first != words.end();) {
+        const std::string_view word = *first;
+        const auto last = std::find_if(first, words.end(), [word](const std::string_view other) {
+            return other != word;
+        });
+        const double term_freq = (last - first) * inv_word_count;
+        first = last;
+
+        // every interned word is a key here, so a known word costs one lookup
+        auto iter = word_to_document_freqs_.lower_bound(word);
+        if (iter == word_to_document_freqs_.end() || iter->first != word) {
+            iter = word_to_document_freqs_.emplace_hint(
+                    iter, std::piecewise_construct, std::forward_as_tuple(InternWord(word)),
+                    std::forward_as_tuple(word_to_document_freqs_.get_allocator(), options_.scoring == Scoring::BM25));
+            SEARCH_COUNT(*stats_, SearchCounter::WORD_CACHE_MISSES, 1);
+        } else {
+            SEARCH_COUNT(*stats_, SearchCounter::WORD_CACHE_HITS, 1);
+        }
+        iter->second.MutablePartition(static_cast<int>(status)).Insert(document_id, term_freq, words.size());
+        // words arrive sorted, so the forward index only ever appends
+        if (options_.compact) {
+            document_words->push_back(iter->first);
+        } else {
+            word_freqs->emplace_hint(word_freqs->end(), iter->first, term_freq); //new index id->words
+        }
+        if (options_.store_positions) {
+            interned_words.push_back(iter->first);
+        }
+    }
+    if (options_.compact) {
+        document_words->shrink_to_fit();
     }
-    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status});
+    if (options_.store_positions) {
+        AddDocumentPositions(document_id, document.word_positions_, interned_words);
+    }
+    documents_.emplace(document_id, DocumentData{document.rating_, status, static_cast<uint32_t>(words.size())});
+    total_document_length_ += words.size();
     document_ids_.insert(document_id);
 }
 
 
 std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
-    });
+    return FindTopDocuments(std::execution::seq, raw_query, status);
 }
 std::vector<Document> SearchServer::FindTopDocuments(std::execution::parallel_policy policy, const std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(policy, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
+    return FindTopDocuments(policy, raw_query, std::optional(status), [](int document_id, DocumentStatus document_status, int rating) {
+        return true;
     });
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(policy, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
+    return FindTopDocuments(policy, raw_query, std::optional(status), [](int document_id, DocumentStatus document_status, int rating) {
+        return true;
     });
 }
 
+std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentStatus status,
+                                                     const QueryControl& control) const {
+    return FindTopDocuments(std::execution::seq, raw_query, std::optional(status), [](int document_id, DocumentStatus document_status, int rating) {
+        return true;
+    }, &control);
+}
+
+SearchPage SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentStatus status,
+                                          const PageRequest& page_request) const {
+    auto documents = FindCandidates(std::execution::seq, raw_query, std::optional(status), [](int document_id, DocumentStatus document_status, int rating) {
+        return true;
+    }, nullptr);
+    SEARCH_STAGE(*stats_, SearchStage::SORT);
+    return BuildPage(std::move(documents), page_request);
+}
+
+SearchPage SearchServer::FindTopDocuments(const std::string_view raw_query, const PageRequest& page_request) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL, page_request);
+}
+
 std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query) const {
     return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
 }
@@ -60,151 +163,147 @@ int SearchServer::GetDocumentCount() const {
 
 //remove document
 void SearchServer::RemoveDocument(std::execution::parallel_policy policy, int document_id) {
-    if (document_to_word_freqs_.count(document_id) == 0) {
-        return;
-    }
-    auto iter = std::find(policy,
-                          document_ids_.begin(), document_ids_.end(),
-                          document_id); // параллельно быстро ищем document_id
-    if (iter == document_ids_.end()) {
+    const auto document_iter = documents_.find(document_id);
+    if (document_iter == documents_.end()) {
         return;
     }
-    documents_.erase(document_id);
-    document_ids_.erase(iter);
+    const int status = static_cast<int>(document_iter->second.status);
 
     // удаляем упоминания в word_to_document_freqs_
     // сохраним слова, по которым надо итерироваться
-    auto& words_to_freqs = document_to_word_freqs_.at(document_id);
     std::vector<std::string_view> words; // все ради итераторов произвольного доступа
-    words.reserve(words_to_freqs.size());
-
-    std::transform(
-            policy,
-            words_to_freqs.begin(), words_to_freqs.end(),
-            words.begin(),
-            [&](const auto& word) {
-                return word.first;
-            });
+    ForEachDocumentWord(document_id, [&words](const std::string_view word) {
+        words.push_back(word);
+    });
     std::for_each(policy,
                   words.begin(), words.end(),
                   [&](const auto& word){
-                      word_to_document_freqs_[word].erase(document_id);
+                      word_to_document_freqs_.at(word).MutablePartition(status).Erase(document_id);
                   });
 
+    total_document_length_ -= document_iter->second.length;
+    documents_.erase(document_iter);
+    document_ids_.erase(document_id);
     document_to_word_freqs_.erase(document_id);
+    document_to_words_.erase(document_id);
+    document_positions_.erase(document_id);
 }
 
 void SearchServer::RemoveDocument(int document_id) {
-    if (document_to_word_freqs_.count(document_id) == 0) {
+    const auto document_iter = documents_.find(document_id);
+    if (document_iter == documents_.end()) {
         return;
     }
-    auto iter = document_ids_.find(document_id); // параллельно быстро ищем document_id
-    if (iter == document_ids_.end()) {
-        return;
-    }
-    documents_.erase(document_id);
-    document_ids_.erase(iter);
+    const int status = static_cast<int>(document_iter->second.status);
+    ForEachDocumentWord(document_id, [&](const std::string_view word) {
+        word_to_document_freqs_.at(word).MutablePartition(status).Erase(document_id);
+    });
 
-    std::map<std::string_view, double>& words_to_freqs = document_to_word_freqs_.at(document_id);
-    for (const auto& word: words_to_freqs) {
-        word_to_document_freqs_[word.first].erase(document_id);
-    }
+    total_document_length_ -= document_iter->second.length;
+    documents_.erase(document_iter);
+    document_ids_.erase(document_id);
     document_to_word_freqs_.erase(document_id);
+    document_to_words_.erase(document_id);
+    document_positions_.erase(document_id);
 }
 
 void SearchServer::RemoveDocument(std::execution::sequenced_policy policy, int document_id) {
     RemoveDocument(document_id);
 }
 
-std::set<int>::const_iterator SearchServer::begin() const {
+// moves the document's postings to another status partition without reindexing it
+void SearchServer::SetDocumentStatus(int document_id, DocumentStatus status) {
+    const auto document_iter = documents_.find(document_id);
+    if (document_iter == documents_.end()) {
+        throw std::invalid_argument("Invalid document_id"s);
+    }
+    const int old_status = static_cast<int>(document_iter->second.status);
+    const int new_status = static_cast<int>(status);
+    if (old_status == new_status) {
+        return;
+    }
+    ForEachDocumentWord(document_id, [&](const std::string_view word) {
+        WordPostings& postings = word_to_document_freqs_.at(word);
+        const double term_freq = postings.MutablePartition(old_status).Extract(document_id);
+        postings.MutablePartition(new_status).Insert(document_id, term_freq, document_iter->second.length);
+    });
+    document_iter->second.status = status;
+}
+
+SearchServer::DocumentIds::const_iterator SearchServer::begin() const {
     return document_ids_.begin();
 }
 
-std::set<int>::const_iterator SearchServer::end() const {
+SearchServer::DocumentIds::const_iterator SearchServer::end() const {
     return document_ids_.end();
 }
 
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    static const std::map<std::string_view, double> dummy;
-    if (document_to_word_freqs_.count(document_id) == 0) {
+const SearchServer::WordFrequencies& SearchServer::GetWordFrequencies(int document_id) const {
+    static const WordFrequencies dummy;
+    const auto document_iter = documents_.find(document_id);
+    if (document_iter == documents_.end()) {
         return dummy;
     }
-    return document_to_word_freqs_.at(document_id);
+    if (!options_.compact) {
+        return document_to_word_freqs_.at(document_id);
+    }
+    // shared by every call on this thread, see the lifetime note in the header
+    thread_local WordFrequencies word_freqs;
+    word_freqs.clear();
+    const int status = static_cast<int>(document_iter->second.status);
+    for (const std::string_view word : document_to_words_.at(document_id)) {
+        word_freqs.emplace_hint(word_freqs.end(), word,
+                                word_to_document_freqs_.at(word).Partition(status).TermFreq(document_id));
+    }
+    return word_freqs;
+}
+
+SearchStats SearchServer::GetStats() const {
+#ifdef SEARCH_SERVER_STATS
+    SearchStats stats = stats_->Snapshot();
+#else
+    SearchStats stats;
+#endif
+    stats.index.document_count = documents_.size();
+    stats.index.word_count = word_to_document_freqs_.size();
+    for (const auto& [_, postings] : word_to_document_freqs_) {
+        stats.index.posting_count += postings.DocumentCount();
+    }
+    stats.index.memory = MemoryUsage();
+    return stats;
+}
+
+IndexMemoryUsage SearchServer::MemoryUsage() const {
+    IndexMemoryUsage usage;
+    const MemoryCounters& counters = *memory_counters_;
+    usage.doc_words = counters.doc_words.load(std::memory_order_relaxed);
+    usage.word_to_document_freqs = counters.word_to_document_freqs.load(std::memory_order_relaxed);
+    usage.documents = counters.documents.load(std::memory_order_relaxed);
+    usage.document_ids = counters.document_ids.load(std::memory_order_relaxed);
+    // shared by both forward indexes
+    usage.document_to_word_freqs = counters.document_to_word_freqs.load(std::memory_order_relaxed);
+    usage.document_positions = counters.document_positions.load(std::memory_order_relaxed);
+    return usage;
 }
 
 
 
+// a query has a handful of words, so splitting one document's match across
+// threads costs more than it saves; MatchDocuments parallelises over the
+// documents instead, after copying their ids into a vector the parallel
+// algorithm can split
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(
         std::execution::parallel_policy policy,
         const std::string_view& raw_query,
         int document_id) const {
-    const Query query = ParseQuery(policy, raw_query);
-    const auto& docwords = document_to_word_freqs_.at(document_id);
-    const auto& mw = query.minus_words;
-    bool hasMinusWord = std::any_of(
-            policy, docwords.begin(), docwords.end(),
-            [&](const auto& par){
-                return std::find(mw.begin(), mw.end(),par.first) != mw.end();
-            });
-    if (hasMinusWord){
-        return {{}, documents_.at(document_id).status};
-    }
-    const auto& pw = query.plus_words;
-
-    std::vector<std::string_view> matched_words(pw.size());
-    auto cop = std::copy_if(policy,
-                            pw.begin(), pw.end(),
-                            matched_words.begin(),
-                            [&](const auto& w){
-                                return docwords.count(w) > 0;
-                            });
-    matched_words.erase(cop, matched_words.end());
-    std::sort(matched_words.begin(), matched_words.end());
-    cop = std::unique(policy, matched_words.begin(), matched_words.end());
-    matched_words.erase(cop, matched_words.end());
-    matched_words.shrink_to_fit();
-    std::transform(
-            policy,
-            matched_words.begin(), matched_words.end(),
-            matched_words.begin(),
-            [&](const auto& w){
-                auto iter = doc_words_.find(static_cast<std::string>(w));
-                return std::string_view(*iter);
-            });
-    return {matched_words, documents_.at(document_id).status};
+    return MatchDocument(raw_query, document_id);
 }
 
-
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(
         const std::string_view& raw_query,
         int document_id) const {
-    const Query query = ParseQuery(raw_query);
-    std::vector<std::string_view> matched_words;
-    for (const std::string_view& word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) > 0) {
-            if (word_to_document_freqs_.at(word).count(document_id) > 0) {
-                return {matched_words, documents_.at(document_id).status};
-            }
-        }
-    }
-    for (const std::string_view& word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) > 0) {
-            if (word_to_document_freqs_.at(word).count(document_id) > 0) {
-                matched_words.push_back(word);
-            }
-        }
-    }
-
-    auto cop = std::unique(matched_words.begin(), matched_words.end());
-    matched_words.erase(cop, matched_words.end());
-    matched_words.shrink_to_fit();
-    std::sort(matched_words.begin(), matched_words.end());
-
-    for (std::string_view& el: matched_words) {
-        el = std::string_view(*doc_words_.find(static_cast<std::string>(el)));
-    }
-
-    return {matched_words, documents_.at(document_id).status};
+    SEARCH_STAGE(*stats_, SearchStage::MATCH_DOCUMENT);
+    return MatchQuery(ParseQuery(raw_query), document_id);
 }
 
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(
@@ -216,14 +315,24 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
 //private methods
 
 bool SearchServer::IsStopWord(const std::string_view& word) const {
-    return stop_words_.count(word) > 0;
+    return stop_words_.Contains(word);
 }
 
-bool SearchServer::IsValidWord(const std::string_view& word) {
-    // A valid word must not contain special characters
-    return std::none_of(word.begin(), word.end(), [](char c) {
-        return c >= '\0' && c < ' ';
-    });
+// runs before the matcher is built from the words
+const std::set<std::string, std::less<>>& SearchServer::ValidateStopWords(const std::set<std::string, std::less<>>& stop_words) {
+    if (!all_of(stop_words.begin(), stop_words.end(), IsValidWord)) {
+        throw std::invalid_argument("Some of stop words are invalid"s);
+    }
+    return stop_words;
+}
+
+// outside these ranges BM25 scores can turn negative, and the dense path
+// would take such documents for untouched slots
+const IndexOptions& SearchServer::ValidateOptions(const IndexOptions& options) {
+    if (!(options.bm25.k1 >= 0.0) || !(options.bm25.b >= 0.0 && options.bm25.b <= 1.0)) {
+        throw std::invalid_argument("BM25 needs k1 >= 0 and 0 <= b <= 1"s);
+    }
+    return options;
 }
 
 std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(const std::string_view& text) const {
@@ -239,6 +348,35 @@ std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(const std::stri
     return words;
 }
 
+// stores a copy of the word the index has not seen before
+std::string_view SearchServer::InternWord(const std::string_view word) {
+    return doc_words_.Store(word);
+}
+
+void SearchServer::AddDocumentPositions(int document_id,
+                                        const std::vector<std::pair<std::string_view, uint32_t>>& word_positions,
+                                        const std::vector<std::string_view>& interned_words) {
+    auto& document_positions = document_positions_.try_emplace(
+            document_id, document_positions_.get_allocator()).first->second;
+    std::vector<uint32_t> positions;
+    auto iter = word_positions.begin();
+    // interned_words holds the same distinct words in the same order
+    for (const std::string_view word : interned_words) {
+        positions.clear();
+        for (; iter != word_positions.end() && iter->first == word; ++iter) {
+            positions.push_back(iter->second);
+        }
+        document_positions.Append(word, positions);
+    }
+}
+
+SearchServer::ParsedDocument::ParsedDocument(int id, DocumentStatus status, int rating,
+                                             std::vector<std::string_view> words)
+        : id_(id)
+        , status_(status)
+        , rating_(rating)
+        , words_(std::move(words)) {}
+
 int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
     if (ratings.empty()) {
         return 0;
@@ -248,34 +386,54 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
 }
 
 SearchServer::QueryWord SearchServer::ParseQueryWord(const std::string_view& text) const {
-    if (text.empty()) {
-        throw std::invalid_argument("Query word is empty"s);
-    }
-    std::string_view word = text;
-    bool is_minus = false;
-    if (word[0] == '-') {
-        is_minus = true;
-        word = word.substr(1);
+    const QueryWordSyntax syntax = ParseQueryWordSyntax(text);
+    return {syntax.word, syntax.is_minus, IsStopWord(syntax.word), syntax.is_pattern};
+}
+
+// indexed words matching the pattern that have postings in the statuses
+// [first_status, last_status), in lexicographic order
+std::vector<std::string_view> SearchServer::ExpandPattern(const std::string_view pattern, bool is_minus,
+                                                          int first_status, int last_status) const {
+    std::vector<std::string_view> words;
+    ExpandWildcard(pattern, is_minus, word_to_document_freqs_.lower_bound(WildcardPrefix(pattern)),
+                   word_to_document_freqs_.end(),
+                   [](auto iter) {
+                       return std::string_view(iter->first);
+                   },
+                   [&](auto iter) {
+                       for (int s = first_status; s < last_status; ++s) {
+                           if (!iter->second.Partition(s).empty()) {
+                               return true;
+                           }
+                       }
+                       return false;
+                   },
+                   [&](auto iter) {
+                       words.push_back(iter->first);
+                   });
+    return words;
+}
+
+void SearchServer::AddQueryWord(const QueryWord& query_word, Query& query) const {
+    if (query_word.is_stop) {
+        return;
     }
-    if (word.empty() || word[0] == '-' || !IsValidWord(word)) {
-        throw std::invalid_argument("Query word "s + static_cast<std::string>(text) + " is invalid"s);
+    if (query_word.is_pattern) {
+        (query_word.is_minus ? query.minus_patterns : query.plus_patterns).push_back(query_word.data);
+    } else {
+        (query_word.is_minus ? query.minus_words : query.plus_words).push_back(query_word.data);
     }
-
-    return {word, is_minus, IsStopWord(word)};
 }
 
 SearchServer::Query SearchServer::ParseQuery(const std::string_view& text) const {
+    SEARCH_STAGE(*stats_, SearchStage::PARSE);
     Query result;
-    const auto words = SplitIntoWords(text);
+    auto words = SplitIntoWords(text);
+    if (options_.store_positions) {
+        words = ExtractPhrases(words, result.phrases);
+    }
     for (const std::string_view& word: words) {
-        const auto query_word = ParseQueryWord(word);
-        if (!query_word.is_stop) {
-            if (query_word.is_minus) {
-                result.minus_words.push_back(query_word.data);
-            } else {
-                result.plus_words.push_back(query_word.data);
-            }
-        }
+        AddQueryWord(ParseQueryWord(word), result);
     }
     std::sort(result.minus_words.begin(), result.minus_words.end());
     std::sort(result.plus_words.begin(), result.plus_words.end());
@@ -285,12 +443,21 @@ SearchServer::Query SearchServer::ParseQuery(const std::string_view& text) const
     cop = std::unique(result.plus_words.begin(), result.plus_words.end());
     result.plus_words.erase(cop, result.plus_words.end());
     result.plus_words.shrink_to_fit();
+    for (auto* patterns : {&result.plus_patterns, &result.minus_patterns}) {
+        std::sort(patterns->begin(), patterns->end());
+        patterns->erase(std::unique(patterns->begin(), patterns->end()), patterns->end());
+    }
     return result;
 }
 
 SearchServer::Query SearchServer::ParseQuery(std::execution::parallel_policy policy,
                                              const std::string_view& text) const {
+    SEARCH_STAGE(*stats_, SearchStage::PARSE);
     std::vector<std::string_view> words = SplitIntoWords(text);
+    Query result;
+    if (options_.store_positions) {
+        words = ExtractPhrases(words, result.phrases);
+    }
     std::vector<QueryWord> qwords(words.size());
     std::transform(policy,
                    words.begin(), words.end(),
@@ -298,17 +465,10 @@ SearchServer::Query SearchServer::ParseQuery(std::execution::parallel_policy pol
                    [&](const auto& w){
                        return ParseQueryWord(w);
                    });
-    Query result;
     result.minus_words.reserve(words.size());
     result.plus_words.reserve(words.size());
     for (const QueryWord& qw: qwords) {
-        if (!qw.is_stop) {
-            if (qw.is_minus) {
-                result.minus_words.emplace_back(qw.data);
-            } else {
-                result.plus_words.emplace_back(qw.data);
-            }
-        }
+        AddQueryWord(qw, result);
     }
     return result;
 }
@@ -318,9 +478,444 @@ SearchServer::Query SearchServer::ParseQuery(std::execution::sequenced_policy po
     return ParseQuery(text);
 }
 
-// Existence required
-double SearchServer::ComputeWordInverseDocumentFreq(const std::string_view& word) const {
-    return std::log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+// one posting lookup per query word in the document's status partition,
+// patterns are expanded over that partition as a search of its status
+// would; the returned views point into the index rather than into the query
+SearchServer::MatchResult SearchServer::MatchQuery(const Query& query, int document_id) const {
+    const DocumentStatus status = documents_.at(document_id).status;
+    const int partition = static_cast<int>(status);
+    std::vector<std::string_view> expanded_plus_words;
+    std::vector<std::string_view> expanded_minus_words;
+    for (const std::string_view pattern : query.plus_patterns) {
+        const auto expansion = ExpandPattern(pattern, false, partition, partition + 1);
+        expanded_plus_words.insert(expanded_plus_words.end(), expansion.begin(), expansion.end());
+    }
+    for (const std::string_view pattern : query.minus_patterns) {
+        const auto expansion = ExpandPattern(pattern, true, partition, partition + 1);
+        expanded_minus_words.insert(expanded_minus_words.end(), expansion.begin(), expansion.end());
+    }
+    const auto find_in_document = [&](const std::string_view word) {
+        const auto iter = word_to_document_freqs_.find(word);
+        if (iter == word_to_document_freqs_.end() || !iter->second.Partition(partition).Contains(document_id)) {
+            return std::string_view();
+        }
+        return iter->first;
+    };
+    std::vector<std::string_view> matched_words;
+    for (const auto* words : {&query.minus_words, &std::as_const(expanded_minus_words)}) {
+        for (const std::string_view& word : *words) {
+            if (!find_in_document(word).empty()) {
+                return {matched_words, status};
+            }
+        }
+    }
+    for (const Phrase& phrase : query.phrases) {
+        if (!DocumentHasPhrase(document_id, phrase)) {
+            return {matched_words, status};
+        }
+    }
+    for (const auto* words : {&query.plus_words, &std::as_const(expanded_plus_words)}) {
+        for (const std::string_view& word : *words) {
+            if (const std::string_view indexed = find_in_document(word); !indexed.empty()) {
+                matched_words.push_back(indexed);
+            }
+        }
+    }
+    if (!query.plus_patterns.empty()) {
+        std::sort(matched_words.begin(), matched_words.end());
+        matched_words.erase(std::unique(matched_words.begin(), matched_words.end()), matched_words.end());
+    }
+    return {matched_words, status};
+}
+
+// strips the quotes of "quoted phrases" and records their words; the words
+// themselves stay in the query as ordinary plus words
+std::vector<std::string_view> SearchServer::ExtractPhrases(const std::vector<std::string_view>& words,
+                                                           std::vector<Phrase>& phrases) const {
+    std::vector<std::string_view> result;
+    result.reserve(words.size());
+    std::optional<Phrase> phrase;
+    uint32_t offset = 0;
+    for (std::string_view word : words) {
+        if (word.substr(0, 2) == "-\""sv) {
+            throw std::invalid_argument("Minus phrases are not supported"s);
+        }
+        if (!phrase && word.front() == '"') {
+            word.remove_prefix(1);
+            phrase.emplace();
+            offset = 0;
+        }
+        bool closes = false;
+        if (phrase && !word.empty() && word.back() == '"') {
+            word.remove_suffix(1);
+            closes = true;
+        }
+        if (phrase) {
+            if (word.empty() || word.front() == '-' || word.find_first_of("*?"sv) != word.npos) {
+                throw std::invalid_argument("Query phrase is invalid"s);
+            }
+            if (!IsStopWord(word)) {
+                phrase->words.emplace_back(word, offset);
+            }
+            ++offset;
+        }
+        result.push_back(word);
+        if (closes) {
+            // a single word needs no positional check
+            if (phrase->words.size() > 1) {
+                phrases.push_back(std::move(*phrase));
+            }
+            phrase.reset();
+        }
+    }
+    if (phrase) {
+        throw std::invalid_argument("Query phrase is not closed"s);
+    }
+    return result;
+}
+
+bool SearchServer::DocumentHasPhrase(int document_id, const Phrase& phrase) const {
+    const DocumentPositions& document_positions = document_positions_.at(document_id);
+    std::vector<std::vector<uint32_t>> positions;
+    positions.reserve(phrase.words.size());
+    for (const auto& [word, _] : phrase.words) {
+        positions.push_back(document_positions.Positions(word));
+        if (positions.back().empty()) {
+            return false;
+        }
+    }
+    const uint32_t first_offset = phrase.words.front().second;
+    for (const uint32_t start : positions.front()) {
+        bool found = true;
+        for (size_t i = 1; found && i < positions.size(); ++i) {
+            found = std::binary_search(positions[i].begin(), positions[i].end(),
+                                       start - first_offset + phrase.words[i].second);
+        }
+        if (found) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// the closest two occurrences of different words are neighbours once all
+// occurrences are merged by position
+double SearchServer::ComputeProximityBoost(int document_id, const std::vector<std::string_view>& words) const {
+    const DocumentPositions& document_positions = document_positions_.at(document_id);
+    std::vector<std::pair<uint32_t, size_t>> occurrences;
+    for (size_t i = 0; i < words.size(); ++i) {
+        for (const uint32_t position : document_positions.Positions(words[i])) {
+            occurrences.emplace_back(position, i);
+        }
+    }
+    std::sort(occurrences.begin(), occurrences.end());
+    uint32_t min_distance = 0;
+    for (size_t i = 1; i < occurrences.size(); ++i) {
+        if (occurrences[i].second != occurrences[i - 1].second) {
+            const uint32_t distance = occurrences[i].first - occurrences[i - 1].first;
+            if (min_distance == 0 || distance < min_distance) {
+                min_distance = distance;
+            }
+        }
+    }
+    return min_distance == 0 ? 0.0 : options_.proximity_weight / min_distance;
+}
+
+Bm25Scorer SearchServer::MakeBm25Scorer() const {
+    const double average_length = total_document_length_ > 0
+                                  ? total_document_length_ * 1.0 / documents_.size()
+                                  : 1.0;
+    return Bm25Scorer(options_.bm25, average_length);
+}
+
+// the dense array costs one slot per id in range, so it has to be covered
+// well enough by the postings to beat a map of touched documents
+bool SearchServer::UseDenseScores(size_t posting_count) const {
+    if (posting_count == 0) {
+        return false;
+    }
+    const size_t id_range = static_cast<size_t>(*document_ids_.rbegin() - *document_ids_.begin()) + 1;
+    return id_range <= DENSE_SCORE_RATIO * posting_count;
+}
+
+template <typename Scorer>
+std::vector<std::pair<int, double>> SearchServer::ScoreDense(bool parallel, const std::vector<ScanList>& plus_lists,
+                                                             const std::vector<int>& excluded_ids,
+                                                             const QueryControl* control, const Scorer& scorer) const {
+    if (options_.score_precision == ScorePrecision::FLOAT) {
+        return AccumulateDense<float>(parallel, plus_lists, excluded_ids, control, scorer);
+    }
+    return AccumulateDense<double>(parallel, plus_lists, excluded_ids, control, scorer);
+}
+
+template std::vector<std::pair<int, double>> SearchServer::ScoreDense(
+        bool, const std::vector<ScanList>&, const std::vector<int>&, const QueryControl*, const TfIdfScorer&) const;
+template std::vector<std::pair<int, double>> SearchServer::ScoreDense(
+        bool, const std::vector<ScanList>&, const std::vector<int>&, const QueryControl*, const Bm25Scorer&) const;
+
+template <typename Score, typename Scorer>
+std::vector<std::pair<int, double>> SearchServer::AccumulateDense(bool parallel, const std::vector<ScanList>& plus_lists,
+                                                                  const std::vector<int>& excluded_ids,
+                                                                  const QueryControl* control, const Scorer& scorer) const {
+    const int base = *document_ids_.begin();
+    const size_t id_range = static_cast<size_t>(*document_ids_.rbegin() - base) + 1;
+    // -0.0 marks a slot no posting has touched, see score_kernel.h; excluded
+    // slots start at -infinity, which stays negative whatever is added, so
+    // the kernels need no per-posting check and CollectScores skips them
+    std::vector<Score> scores(id_range, static_cast<Score>(-0.0));
+    for (const int document_id : excluded_ids) {
+        scores[document_id - base] = -std::numeric_limits<Score>::infinity();
+    }
+    {
+        SEARCH_STAGE(*stats_, SearchStage::POSTING_SCAN);
+        // postings are sorted by id, so a block of slots takes one contiguous
+        // slice of every list and blocks can be scored independently
+        const auto score_block = [&](size_t first_slot, size_t last_slot) {
+            const int first_id = base + static_cast<int>(first_slot);
+            const int last_id = base + static_cast<int>(last_slot);
+            for (const ScanList& list : plus_lists) {
+                const auto& document_ids = list.postings->DocumentIds();
+                const auto& term_freqs = list.postings->TermFreqs();
+                size_t first = std::lower_bound(document_ids.begin(), document_ids.end(), first_id) - document_ids.begin();
+                const size_t last = std::lower_bound(document_ids.begin() + first, document_ids.end(), last_id) - document_ids.begin();
+                while (first < last) {
+                    if (control != nullptr) {
+                        control->ThrowIfCancelled();
+                    }
+                    const size_t count = std::min<size_t>(last - first, CANCELLATION_CHECK_INTERVAL);
+                    if constexpr (Scorer::NEEDS_LENGTHS) {
+                        const auto& document_lengths = list.postings->DocumentLengths();
+                        for (size_t i = first; i < first + count; ++i) {
+                            scores[document_ids[i] - base] += static_cast<Score>(
+                                    scorer.Score(list.inverse_document_freq, term_freqs[i], document_lengths[i]));
+                        }
+                    } else {
+                        // the TF-IDF product is exactly what the SIMD kernel computes
+                        AccumulateScores(document_ids.data() + first, term_freqs.data() + first, count,
+                                         list.inverse_document_freq, base, scores.data());
+                    }
+                    first += count;
+                }
+            }
+        };
+        const size_t block_count = (id_range + DENSE_SCORE_BLOCK_SIZE - 1) / DENSE_SCORE_BLOCK_SIZE;
+        if (parallel && block_count > 1) {
+            std::vector<size_t> blocks(block_count);
+            std::iota(blocks.begin(), blocks.end(), 0);
+            ParallelCancellation cancellation;
+            std::for_each(std::execution::par, blocks.begin(), blocks.end(), [&](size_t block) {
+                cancellation.Run([&] {
+                    score_block(block * DENSE_SCORE_BLOCK_SIZE, std::min(id_range, (block + 1) * DENSE_SCORE_BLOCK_SIZE));
+                });
+            });
+            cancellation.Rethrow();
+        } else {
+            score_block(0, id_range);
+        }
+    }
+
+    std::vector<std::pair<int, double>> document_to_relevance;
+    size_t posting_count = 0;
+    for (const ScanList& list : plus_lists) {
+        posting_count += list.postings->size();
+    }
+    document_to_relevance.reserve(std::min(id_range, posting_count));
+    CollectScores(scores.data(), id_range, base, document_to_relevance);
+    SEARCH_COUNT(*stats_, SearchCounter::DOCUMENTS_SCORED, document_to_relevance.size());
+    return document_to_relevance;
+}
+
+// looks every query word up once. Plus words without postings in the scanned
+// partitions are dropped and the rest ordered by posting count, so the scan
+// starts with the most selective lists; the documents of the minus words are
+// collected before any scoring, so the scan can pass them over
+SearchServer::QueryPlan SearchServer::PlanQuery(const Query& query, int first_status, int last_status) const {
+    const auto find_term = [&](const std::string_view word) -> std::optional<QueryPlan::Term> {
+        const auto iter = word_to_document_freqs_.find(word);
+        if (iter == word_to_document_freqs_.end()) {
+            return std::nullopt;
+        }
+        size_t posting_count = 0;
+        for (int s = first_status; s < last_status; ++s) {
+            posting_count += iter->second.Partition(s).size();
+        }
+        if (posting_count == 0) {
+            return std::nullopt;
+        }
+        return QueryPlan::Term{iter->first, &iter->second, posting_count};
+    };
+    // the parallel ParseQuery leaves repeats in place
+    const auto unique_words = [](std::vector<std::string_view> words) {
+        std::sort(words.begin(), words.end());
+        words.erase(std::unique(words.begin(), words.end()), words.end());
+        return words;
+    };
+
+    QueryPlan plan;
+    std::vector<std::string_view> plus_words = query.plus_words;
+    for (const std::string_view pattern : unique_words(query.plus_patterns)) {
+        const auto expansion = ExpandPattern(pattern, false, first_status, last_status);
+        if (expansion.empty()) {
+            plan.dropped_words.push_back(pattern);
+        }
+        plus_words.insert(plus_words.end(), expansion.begin(), expansion.end());
+    }
+    for (const std::string_view word : unique_words(std::move(plus_words))) {
+        if (const auto term = find_term(word)) {
+            plan.plus_terms.push_back(*term);
+            plan.posting_count += term->posting_count;
+        } else {
+            plan.dropped_words.push_back(word);
+        }
+    }
+    std::sort(plan.plus_terms.begin(), plan.plus_terms.end(), [](const QueryPlan::Term& lhs, const QueryPlan::Term& rhs) {
+        return std::tie(lhs.posting_count, lhs.word) < std::tie(rhs.posting_count, rhs.word);
+    });
+    if (plan.plus_terms.empty()) {
+        return plan;
+    }
+
+    SEARCH_STAGE(*stats_, SearchStage::MINUS_WORDS);
+    std::vector<std::string_view> minus_words = query.minus_words;
+    for (const std::string_view pattern : query.minus_patterns) {
+        const auto expansion = ExpandPattern(pattern, true, first_status, last_status);
+        minus_words.insert(minus_words.end(), expansion.begin(), expansion.end());
+    }
+    for (const std::string_view word : unique_words(std::move(minus_words))) {
+        const auto term = find_term(word);
+        if (!term) {
+            continue;
+        }
+        plan.minus_terms.push_back(*term);
+        // every posting list is sorted already, so merging keeps the ids
+        // ascending without a full sort
+        for (int s = first_status; s < last_status; ++s) {
+            const auto& document_ids = term->postings->Partition(s).DocumentIds();
+            const size_t middle = plan.excluded_ids.size();
+            plan.excluded_ids.insert(plan.excluded_ids.end(), document_ids.begin(), document_ids.end());
+            std::inplace_merge(plan.excluded_ids.begin(), plan.excluded_ids.begin() + middle, plan.excluded_ids.end());
+        }
+    }
+    plan.excluded_ids.erase(std::unique(plan.excluded_ids.begin(), plan.excluded_ids.end()), plan.excluded_ids.end());
+    return plan;
+}
+
+std::string SearchServer::ExplainQuery(const std::string_view raw_query, std::optional<DocumentStatus> status) const {
+    static const char* const STATUS_NAMES[STATUS_COUNT] = {"ACTUAL", "IRRELEVANT", "BANNED", "REMOVED"};
+    const Query query = ParseQuery(raw_query);
+    const auto [first_status, last_status] = StatusRange(status);
+    const QueryPlan plan = PlanQuery(query, first_status, last_status);
+    const auto weight = [&](const QueryPlan::Term& term) {
+        const size_t document_count = term.postings->DocumentCount();
+        return options_.scoring == Scoring::BM25 ? MakeBm25Scorer().Weight(GetDocumentCount(), document_count)
+                                                 : TfIdfScorer().Weight(GetDocumentCount(), document_count);
+    };
+
+    std::ostringstream out;
+    out << "status: "s << (status ? STATUS_NAMES[first_status] : "any") << '\n';
+    out << "scoring: "s << (options_.scoring == Scoring::BM25 ? "bm25" : "tf-idf") << '\n';
+    out << "scan: "s << plan.plus_terms.size() << " words, "s << plan.posting_count << " postings, "s;
+    if (plan.plus_terms.empty()) {
+        out << "no results"s << '\n';
+    } else if (UseDenseScores(plan.posting_count)) {
+        out << "dense scores over "s << *document_ids_.rbegin() - *document_ids_.begin() + 1 << " ids"s << '\n';
+    } else {
+        out << "sparse scores"s << '\n';
+    }
+    for (const QueryPlan::Term& term : plan.plus_terms) {
+        out << "  "s << term.word << ": "s << term.posting_count << " postings, weight "s << weight(term) << '\n';
+    }
+    if (!plan.dropped_words.empty()) {
+        out << "dropped (no postings):"s;
+        for (const std::string_view word : plan.dropped_words) {
+            out << ' ' << word;
+        }
+        out << '\n';
+    }
+    if (!plan.minus_terms.empty()) {
+        out << "exclude: "s << plan.excluded_ids.size() << " documents"s << '\n';
+        for (const QueryPlan::Term& term : plan.minus_terms) {
+            out << "  -"s << term.word << ": "s << term.posting_count << " postings"s << '\n';
+        }
+    }
+    if (!query.phrases.empty()) {
+        out << "phrases: "s << query.phrases.size() << " checked after the scan"s << '\n';
+    }
+    return out.str();
+}
+
+// partial selection: only the first count documents end up sorted
+void SearchServer::SelectTopDocuments(std::vector<Document>& documents, size_t count) {
+    const size_t top = std::min(count, documents.size());
+    std::partial_sort(documents.begin(), documents.begin() + top, documents.end(), IsRankedHigher);
+    documents.resize(top);
+}
+
+SearchPage SearchServer::BuildPage(std::vector<Document> documents, const PageRequest& page_request) {
+    if (page_request.page_size == 0) {
+        throw std::invalid_argument("Page size must be positive"s);
+    }
+    size_t skip = 0;
+    if (page_request.after) {
+        const PageToken& token = *page_request.after;
+        const Document last_seen(token.id, token.relevance, token.rating);
+        documents.erase(std::remove_if(documents.begin(), documents.end(), [&last_seen](const Document& document) {
+            return !IsRankedHigher(last_seen, document);
+        }), documents.end());
+    } else if (page_request.page <= documents.size() / page_request.page_size) {
+        skip = page_request.page * page_request.page_size;
+    } else {
+        skip = documents.size();
+    }
+    const size_t total = documents.size();
+    const size_t window = std::min(total, skip + page_request.page_size);
+    SelectTopDocuments(documents, window);
+
+    std::optional<PageToken> next_page;
+    if (window < total) {
+        const Document& last = documents.back();
+        next_page = PageToken{last.relevance, last.rating, last.id};
+    }
+    return SearchPage(std::make_shared<const std::vector<Document>>(std::move(documents)), skip, window, next_page);
+}
+
+std::pair<int, int> SearchServer::StatusRange(std::optional<DocumentStatus> status) {
+    if (!status) {
+        return {0, STATUS_COUNT};
+    }
+    return {static_cast<int>(*status), static_cast<int>(*status) + 1};
+}
+
+SearchServer::WordPostings::WordPostings(const PostingList::allocator_type& allocator, bool store_lengths)
+        : actual_(allocator, store_lengths)
+        , other_statuses_(allocator) {}
+
+const PostingList& SearchServer::WordPostings::Partition(int status) const {
+    static const PostingList empty{PostingList::allocator_type()};
+    if (status == static_cast<int>(DocumentStatus::ACTUAL)) {
+        return actual_;
+    }
+    return other_statuses_.empty() ? empty : other_statuses_[status - 1];
+}
+
+PostingList& SearchServer::WordPostings::MutablePartition(int status) {
+    if (status == static_cast<int>(DocumentStatus::ACTUAL)) {
+        return actual_;
+    }
+    if (other_statuses_.empty()) {
+        other_statuses_.reserve(STATUS_COUNT - 1);
+        for (int s = 1; s < STATUS_COUNT; ++s) {
+            other_statuses_.emplace_back(actual_.get_allocator(), actual_.StoresLengths());
+        }
+    }
+    return other_statuses_[status - 1];
+}
+
+size_t SearchServer::WordPostings::DocumentCount() const {
+    return std::accumulate(other_statuses_.begin(), other_statuses_.end(), actual_.size(),
+                           [](size_t lhs, const PostingList& rhs) {
+                               return lhs + rhs.size();
+                           });
 }
 
 //Functions out of class
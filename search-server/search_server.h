@@ -1,33 +1,105 @@
 #pragma once
 #include <map>
 #include <set>
+#include <memory>
+#include <array>
 #include <vector>
+#include <optional>
 #include <cmath>
 #include <algorithm>
 #include <execution>
 #include <stdexcept>
+#include <string>
 #include "document.h"
 #include "string_processing.h"
 #include "concurrent_map.h"
 #include "log_duration.h"
+#include "search_stats.h"
+#include "counting_allocator.h"
+#include "query_control.h"
+#include "posting_list.h"
+#include "search_page.h"
+#include "document_positions.h"
+#include "string_arena.h"
+#include "score_kernel.h"
+#include "query_parsing.h"
+#include "stop_word_matcher.h"
+#include "scoring.h"
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 const double ACCURACY_THRESHOLD = 1e-6;
 const int BUCKET_COUNT = 8;
+const int STATUS_COUNT = 4;
+// scores go to a dense array indexed by document id when the id range is at
+// most this many times the number of postings a query scans
+const size_t DENSE_SCORE_RATIO = 8;
+// slots of the dense array scored by one task of a parallel query
+const size_t DENSE_SCORE_BLOCK_SIZE = 16384;
+
+// result order: relevance descending (values closer than ACCURACY_THRESHOLD
+// are equal), then rating descending, then id ascending
+bool IsRankedHigher(const Document& lhs, const Document& rhs);
+
+struct IndexOptions {
+    // keep only the sorted word list of each document instead of a forward
+    // word -> frequency map; frequencies are then read from the postings
+    bool compact = false;
+    // keep word positions for "quoted phrase" queries and proximity boosting;
+    // without it quotes are ordinary characters of a word
+    bool store_positions = false;
+    // with store_positions, relevance grows by proximity_weight / d where d
+    // is the smallest distance between two different query words in the document
+    double proximity_weight = 0.0;
+    // accumulator type of the dense scoring path
+    ScorePrecision score_precision = ScorePrecision::DOUBLE;
+    // relevance formula; BM25 makes every posting keep its document length
+    Scoring scoring = Scoring::TF_IDF;
+    Bm25Parameters bm25;
+};
 
 class SearchServer {
 public:
+    using WordFrequencies = CountedMap<std::string_view, double>;
+    using DocumentIds = CountedSet<int>;
+    using MatchResult = std::tuple<std::vector<std::string_view>, DocumentStatus>;
+
+    // A tokenized document whose words still point into the caller's text.
+    // Only ParseDocument makes one, so AddDocument can rely on its words
+    // being valid, free of stop words and sorted; it is meant for the server
+    // that parsed it.
+    class ParsedDocument {
+    private:
+        friend class SearchServer;
+
+        ParsedDocument(int id, DocumentStatus status, int rating, std::vector<std::string_view> words);
+
+        int id_;
+        DocumentStatus status_;
+        int rating_;
+        // non-stop words in sorted order, repeats kept
+        std::vector<std::string_view> words_;
+        // sorted (word, position) pairs, filled only with IndexOptions::store_positions
+        std::vector<std::pair<std::string_view, uint32_t>> word_positions_;
+    };
+
     //constructors
     template <class StringContainer>
-    explicit SearchServer(const StringContainer& stop_words);
-    explicit SearchServer(const std::string& stop_words_text);
-    explicit SearchServer(std::string_view stop_words_text);
+    explicit SearchServer(const StringContainer& stop_words, IndexOptions options = {});
+    explicit SearchServer(const std::string& stop_words_text, IndexOptions options = {});
+    explicit SearchServer(std::string_view stop_words_text, IndexOptions options = {});
     //document operation methods
     void AddDocument(int document_id, std::string_view document,
                      DocumentStatus status, const std::vector<int>& ratings);
+    // AddDocument split in two stages: ParseDocument reads only the stop words
+    // and options, so it may run on other threads while documents are added;
+    // the text must outlive the AddDocument call that interns its words
+    ParsedDocument ParseDocument(int document_id, std::string_view document,
+                                 DocumentStatus status, const std::vector<int>& ratings) const;
+    void AddDocument(ParsedDocument&& document);
     void RemoveDocument(std::execution::parallel_policy policy, int document_id);
     void RemoveDocument(std::execution::sequenced_policy policy, int document_id);
     void RemoveDocument(int document_id);
+    void SetDocumentStatus(int document_id, DocumentStatus status);
 
     //search documents
     template <typename DocumentPredicate, typename ExecPolicy>
@@ -38,6 +110,14 @@ public:
     std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
     std::vector<Document> FindTopDocuments(std::execution::parallel_policy policy, std::string_view raw_query, DocumentStatus status) const;
     std::vector<Document> FindTopDocuments(std::execution::sequenced_policy policy, std::string_view raw_query, DocumentStatus status) const;
+    // throws QueryCancelled once control is cancelled or past its deadline
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status, const QueryControl& control) const;
+
+    // paging through all results instead of the first MAX_RESULT_DOCUMENT_COUNT
+    template <typename DocumentPredicate>
+    SearchPage FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, const PageRequest& page_request) const;
+    SearchPage FindTopDocuments(std::string_view raw_query, DocumentStatus status, const PageRequest& page_request) const;
+    SearchPage FindTopDocuments(std::string_view raw_query, const PageRequest& page_request) const;
 
     std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
     std::vector<Document> FindTopDocuments(std::execution::parallel_policy policy, std::string_view raw_query) const;
@@ -50,9 +130,14 @@ public:
     std::vector<Document> FindTopDocuments(const ExecPolicy& policy, std::string_view raw_query) const;
     //iterators and getters
     int GetDocumentCount() const;
-    std::set<int>::const_iterator begin() const;
-    std::set<int>::const_iterator end() const;
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    DocumentIds::const_iterator begin() const;
+    DocumentIds::const_iterator end() const;
+    // Word -> term frequency of the document, empty for an unknown id.
+    // In compact mode there is no forward map to refer to: the result is
+    // rebuilt from the postings into one thread_local map, which the next
+    // call on the same thread overwrites, even for another document or
+    // server. Copy the map to keep two results at once.
+    const WordFrequencies& GetWordFrequencies(int document_id) const;
 
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(
             std::execution::parallel_policy policy,
@@ -65,81 +150,202 @@ public:
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(
             const std::string_view& raw_query,
             int document_id) const;
+    // matches one query against many documents, parsing it once; with the
+    // parallel policy the documents are matched concurrently whatever kind
+    // of range holds their ids
+    template <typename ExecPolicy, typename DocumentIdRange>
+    std::vector<MatchResult> MatchDocuments(const ExecPolicy& policy, std::string_view raw_query,
+                                            const DocumentIdRange& document_ids) const;
+
+    // timings and counters are filled only when built with SEARCH_SERVER_STATS
+    SearchStats GetStats() const;
+    IndexMemoryUsage MemoryUsage() const;
+
+    // EXPLAIN for FindTopDocuments: the words in the order the search scans
+    // them with their posting counts and weights, the words it drops and the
+    // documents the minus words exclude; nullopt plans a search with a
+    // predicate, which scans documents of every status
+    std::string ExplainQuery(std::string_view raw_query,
+                             std::optional<DocumentStatus> status = DocumentStatus::ACTUAL) const;
+
+    // serialises the index into the read-only format of mapped_index.h
+    friend std::string BuildIndexImage(const SearchServer& search_server);
 
 private:
     struct DocumentData {
         int rating;
         DocumentStatus status;
+        uint32_t length;   // words without stop words
     };
 
     struct QueryWord {
         std::string_view data;
         bool is_minus;
         bool is_stop;
+        bool is_pattern;
+    };
+
+    // non-stop words of a quoted phrase with their offsets from its first
+    // word; stop words are skipped but still take a position
+    struct Phrase {
+        std::vector<std::pair<std::string_view, uint32_t>> words;
     };
 
     struct Query {
         std::vector<std::string_view> plus_words;
         std::vector<std::string_view> minus_words;
+        // wildcard words, expanded once the searched statuses are known
+        std::vector<std::string_view> plus_patterns;
+        std::vector<std::string_view> minus_patterns;
+        std::vector<Phrase> phrases;
     };
 
-    const std::set<std::string, std::less<>> stop_words_;
-    std::set<std::string> doc_words_;
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, DocumentData> documents_;
-    std::set<int> document_ids_;
-    std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
+    // postings of one word split by document status, so a status-filtered
+    // search never touches documents of other statuses. Most words occur
+    // only in ACTUAL documents, so the other partitions are allocated when
+    // the first document of any other status arrives
+    class WordPostings {
+    public:
+        WordPostings(const PostingList::allocator_type& allocator, bool store_lengths);
+
+        // an empty list for a partition that was never allocated
+        const PostingList& Partition(int status) const;
+        PostingList& MutablePartition(int status);
+        size_t DocumentCount() const;
+
+    private:
+        PostingList actual_;
+        // IRRELEVANT, BANNED and REMOVED in that order, or none of them
+        CountedVector<PostingList> other_statuses_;
+    };
+
+    // one status partition of a plus word's postings
+    struct ScanList {
+        const PostingList* postings;
+        double inverse_document_freq;
+    };
+
+    // what FindAllDocuments scans for one query, built by PlanQuery
+    struct QueryPlan {
+        struct Term {
+            std::string_view word;
+            const WordPostings* postings;
+            size_t posting_count;   // in the scanned status partitions
+        };
+
+        // ascending posting_count, the scan order
+        std::vector<Term> plus_terms;
+        // plus words without postings in the scanned partitions
+        std::vector<std::string_view> dropped_words;
+        std::vector<Term> minus_terms;
+        // ascending ids of scanned documents that hold a minus word
+        std::vector<int> excluded_ids;
+        size_t posting_count = 0;   // of all plus_terms
+    };
+
+    // one counter per figure of IndexMemoryUsage, on the heap so the
+    // allocators' pointers stay valid when the server is moved
+    struct MemoryCounters {
+        MemoryCounter doc_words{0};
+        MemoryCounter word_to_document_freqs{0};
+        MemoryCounter documents{0};
+        MemoryCounter document_ids{0};
+        MemoryCounter document_to_word_freqs{0};
+        MemoryCounter document_positions{0};
+    };
+
+    const IndexOptions options_;
+    const StopWordMatcher stop_words_;
+    std::unique_ptr<MemoryCounters> memory_counters_ = std::make_unique<MemoryCounters>();
+    // characters of every indexed word, the string_views below point here
+    StringArena doc_words_{StringArena::allocator_type(memory_counters_->doc_words)};
+    CountedMap<std::string_view, WordPostings> word_to_document_freqs_{
+            CountingAllocator<char>(memory_counters_->word_to_document_freqs)};
+    CountedMap<int, DocumentData> documents_{CountingAllocator<char>(memory_counters_->documents)};
+    DocumentIds document_ids_{CountingAllocator<char>(memory_counters_->document_ids)};
+    // sum of DocumentData::length, for the average BM25 normalises by
+    uint64_t total_document_length_ = 0;
+    // forward index, only one of the two is filled depending on options_.compact
+    CountedMap<int, WordFrequencies> document_to_word_freqs_{
+            CountingAllocator<char>(memory_counters_->document_to_word_freqs)};
+    CountedMap<int, CountedVector<std::string_view>> document_to_words_{
+            CountingAllocator<char>(memory_counters_->document_to_word_freqs)};
+    // filled only with options_.store_positions
+    CountedMap<int, DocumentPositions> document_positions_{
+            CountingAllocator<char>(memory_counters_->document_positions)};
+#ifdef SEARCH_SERVER_STATS
+    // on the heap like the memory counters: the registry's atomics would
+    // otherwise make the server immovable in instrumented builds only
+    std::unique_ptr<StatsRegistry> stats_ = std::make_unique<StatsRegistry>();
+#endif
 
     bool IsStopWord(const std::string_view& word) const;
-    static bool IsValidWord(const std::string_view& word);
+    static const std::set<std::string, std::less<>>& ValidateStopWords(const std::set<std::string, std::less<>>& stop_words);
+    static const IndexOptions& ValidateOptions(const IndexOptions& options);
     std::vector<std::string_view> SplitIntoWordsNoStop(const std::string_view& text) const;
+    std::string_view InternWord(std::string_view word);
+    void AddDocumentPositions(int document_id,
+                              const std::vector<std::pair<std::string_view, uint32_t>>& word_positions,
+                              const std::vector<std::string_view>& interned_words);
+    template <typename Func>
+    void ForEachDocumentWord(int document_id, Func func) const;
 
     static int ComputeAverageRating(const std::vector<int>& ratings);
     QueryWord ParseQueryWord(const std::string_view& text) const;
+    std::vector<std::string_view> ExpandPattern(std::string_view pattern, bool is_minus, int first_status,
+                                                int last_status) const;
+    void AddQueryWord(const QueryWord& query_word, Query& query) const;
 
     Query ParseQuery(std::execution::parallel_policy policy, const std::string_view& text) const;
     Query ParseQuery(std::execution::sequenced_policy policy, const std::string_view& text) const;
     Query ParseQuery(const std::string_view& text) const;
-    double ComputeWordInverseDocumentFreq(const std::string_view& word) const;
+    MatchResult MatchQuery(const Query& query, int document_id) const;
+    std::vector<std::string_view> ExtractPhrases(const std::vector<std::string_view>& words,
+                                                 std::vector<Phrase>& phrases) const;
+    bool DocumentHasPhrase(int document_id, const Phrase& phrase) const;
+    double ComputeProximityBoost(int document_id, const std::vector<std::string_view>& words) const;
+    Bm25Scorer MakeBm25Scorer() const;
+    static std::pair<int, int> StatusRange(std::optional<DocumentStatus> status);
+    QueryPlan PlanQuery(const Query& query, int first_status, int last_status) const;
+    static bool IsExcluded(const std::vector<int>& excluded_ids, size_t& cursor, int document_id);
 
     template <typename DocumentPredicate, typename ExecPolicy>
-    std::vector<Document> FindAllDocuments(const ExecPolicy& policy, const Query& query, DocumentPredicate document_predicate) const;
-    template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(const ExecPolicy& policy, std::string_view raw_query,
+                                           std::optional<DocumentStatus> status, DocumentPredicate document_predicate,
+                                           const QueryControl* control = nullptr) const;
+    template <typename DocumentPredicate, typename ExecPolicy>
+    std::vector<Document> FindCandidates(const ExecPolicy& policy, std::string_view raw_query,
+                                         std::optional<DocumentStatus> status, DocumentPredicate document_predicate,
+                                         const QueryControl* control) const;
+    bool UseDenseScores(size_t posting_count) const;
+    // instantiated in search_server.cpp for TfIdfScorer and Bm25Scorer
+    template <typename Scorer>
+    std::vector<std::pair<int, double>> ScoreDense(bool parallel, const std::vector<ScanList>& plus_lists,
+                                                   const std::vector<int>& excluded_ids,
+                                                   const QueryControl* control, const Scorer& scorer) const;
+    template <typename Score, typename Scorer>
+    std::vector<std::pair<int, double>> AccumulateDense(bool parallel, const std::vector<ScanList>& plus_lists,
+                                                        const std::vector<int>& excluded_ids,
+                                                        const QueryControl* control, const Scorer& scorer) const;
+    static void SelectTopDocuments(std::vector<Document>& documents, size_t count);
+    static SearchPage BuildPage(std::vector<Document> documents, const PageRequest& page_request);
+    template <typename DocumentPredicate, typename ExecPolicy, typename Scorer>
+    std::vector<Document> FindAllDocuments(const ExecPolicy& policy, const Query& query,
+                                           std::optional<DocumentStatus> status, DocumentPredicate document_predicate,
+                                           const QueryControl* control, const Scorer& scorer) const;
 };
 
 //class template methods/constructors
 template <class StringContainer>
-SearchServer::SearchServer(const StringContainer& stop_words)
-        : stop_words_(MakeUniqueNonEmptyStrings(stop_words))
+SearchServer::SearchServer(const StringContainer& stop_words, IndexOptions options)
+        : options_(ValidateOptions(options))
+        , stop_words_(ValidateStopWords(MakeUniqueNonEmptyStrings(stop_words)))
 {
-    using std::string_literals::operator""s;
-    if (!all_of(stop_words_.begin(), stop_words_.end(), IsValidWord)) {
-        throw std::invalid_argument("Some of stop words are invalid"s);
-    }
 }
 
 template <typename DocumentPredicate, typename ExecPolicy>
 std::vector<Document> SearchServer::FindTopDocuments(const ExecPolicy& policy, const std::string_view raw_query, DocumentPredicate document_predicate) const {
-    std::vector<Document> matched_documents;
-    if (std::is_same_v<std::decay_t<ExecPolicy>, std::execution::parallel_policy>) {
-        const auto query = ParseQuery(policy,raw_query);
-        matched_documents = FindAllDocuments(policy, query, document_predicate);
-    } else {
-        const auto query = ParseQuery(raw_query);
-        matched_documents = FindAllDocuments(query, document_predicate);
-    }
-    sort(matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
-        if (std::abs(lhs.relevance - rhs.relevance) < ACCURACY_THRESHOLD) {
-            return lhs.rating > rhs.rating;
-        } else {
-            return lhs.relevance > rhs.relevance;
-        }
-    });
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
-    }
-    return matched_documents;
+    return FindTopDocuments(policy, raw_query, std::nullopt, document_predicate);
 }
 
 template <typename DocumentPredicate>
@@ -148,68 +354,213 @@ std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_
     return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
 }
 
+template <typename DocumentPredicate>
+SearchPage SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate,
+                                          const PageRequest& page_request) const {
+    auto documents = FindCandidates(std::execution::seq, raw_query, std::nullopt, document_predicate, nullptr);
+    SEARCH_STAGE(*stats_, SearchStage::SORT);
+    return BuildPage(std::move(documents), page_request);
+}
+
 template <typename DocumentPredicate, typename ExecPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(const ExecPolicy& policy, const std::string_view raw_query,
+                                                     std::optional<DocumentStatus> status,
+                                                     DocumentPredicate document_predicate,
+                                                     const QueryControl* control) const {
+    auto matched_documents = FindCandidates(policy, raw_query, status, document_predicate, control);
+    SEARCH_STAGE(*stats_, SearchStage::SORT);
+    SelectTopDocuments(matched_documents, MAX_RESULT_DOCUMENT_COUNT);
+    return matched_documents;
+}
+
+// unordered matches; status == nullopt scans all partitions of the index
+template <typename DocumentPredicate, typename ExecPolicy>
+std::vector<Document> SearchServer::FindCandidates(const ExecPolicy& policy, const std::string_view raw_query,
+                                                   std::optional<DocumentStatus> status,
+                                                   DocumentPredicate document_predicate,
+                                                   const QueryControl* control) const {
+    SEARCH_COUNT(*stats_, SearchCounter::QUERIES, 1);
+    // the only branch on the scorer: each one gets its own posting loop
+    const auto find_all = [&](const auto& exec_policy, const Query& query) {
+        if (options_.scoring == Scoring::BM25) {
+            return FindAllDocuments(exec_policy, query, status, document_predicate, control, MakeBm25Scorer());
+        }
+        return FindAllDocuments(exec_policy, query, status, document_predicate, control, TfIdfScorer());
+    };
+    std::vector<Document> matched_documents;
+    if (std::is_same_v<std::decay_t<ExecPolicy>, std::execution::parallel_policy>) {
+        const auto query = ParseQuery(policy,raw_query);
+        matched_documents = find_all(policy, query);
+    } else {
+        const auto query = ParseQuery(raw_query);
+        matched_documents = find_all(std::execution::seq, query);
+    }
+    return matched_documents;
+}
+
+template <typename DocumentPredicate, typename ExecPolicy, typename Scorer>
 std::vector<Document> SearchServer::FindAllDocuments(const ExecPolicy& policy,
                                                      const SearchServer::Query& query,
-                                                     DocumentPredicate document_predicate) const {
-    std::map<int, double> document_to_relevance;
-    auto pw = query.plus_words;
-    std::sort(policy, pw.begin(), pw.end());
-    auto last = std::unique(policy,pw.begin(), pw.end());
-    pw.erase(last, pw.end());
-    if (std::is_same_v<std::decay_t<ExecPolicy>, std::execution::parallel_policy>) {
-        ConcurrentMap<int, double> document_to_relevance_cm(BUCKET_COUNT);
-        std::for_each(
-            policy,
-            pw.begin(), pw.end(),
-            [this, &document_to_relevance_cm, &document_predicate](const std::string_view& word){
-                if (word_to_document_freqs_.count(word) > 0){
-                    const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-                    for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-                        const auto& document_data = documents_.at(document_id);
-                        if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                            document_to_relevance_cm[document_id].ref_to_value += term_freq * inverse_document_freq;
-                        }
-                    }
-                }
+                                                     std::optional<DocumentStatus> status,
+                                                     DocumentPredicate document_predicate,
+                                                     const QueryControl* control, const Scorer& scorer) const {
+    constexpr bool is_parallel = std::is_same_v<std::decay_t<ExecPolicy>, std::execution::parallel_policy>;
+    const auto [first_status, last_status] = StatusRange(status);
+    const QueryPlan plan = PlanQuery(query, first_status, last_status);
+    SEARCH_COUNT(*stats_, SearchCounter::POSTINGS_SCANNED, plan.posting_count);
+    SEARCH_COUNT(*stats_, SearchCounter::DOCUMENTS_EXCLUDED, plan.excluded_ids.size());
+    if (plan.plus_terms.empty()) {
+        return {};
+    }
+    std::vector<ScanList> plus_lists;
+    for (const QueryPlan::Term& term : plan.plus_terms) {
+        const double inverse_document_freq = scorer.Weight(GetDocumentCount(), term.postings->DocumentCount());
+        for (int s = first_status; s < last_status; ++s) {
+            const PostingList& postings = term.postings->Partition(s);
+            if (!postings.empty()) {
+                plus_lists.push_back({&postings, inverse_document_freq});
             }
-        );
-        document_to_relevance = document_to_relevance_cm.BuildOrdinaryMap();
+        }
+    }
+
+    // ascending document id
+    std::vector<std::pair<int, double>> document_to_relevance;
+    if (UseDenseScores(plan.posting_count)) {
+        document_to_relevance = ScoreDense(is_parallel, plus_lists, plan.excluded_ids, control, scorer);
     } else {
-        for (const std::string_view &word: query.plus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
-                continue;
-            }
-            const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-            for (const auto[document_id, term_freq]: word_to_document_freqs_.at(word)) {
-                const auto &document_data = documents_.at(document_id);
-                if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                    document_to_relevance[document_id] += term_freq * inverse_document_freq;
+        std::map<int, double> relevance_map;
+        if (is_parallel) {
+            SEARCH_STAGE(*stats_, SearchStage::POSTING_SCAN);
+            ConcurrentMap<int, double> document_to_relevance_cm(BUCKET_COUNT);
+            ParallelCancellation cancellation;
+            std::for_each(
+                policy,
+                plus_lists.begin(), plus_lists.end(),
+                [&](const ScanList& list){
+                    cancellation.Run([&] {
+                        const auto& document_ids = list.postings->DocumentIds();
+                        const auto& term_freqs = list.postings->TermFreqs();
+                        const auto& document_lengths = list.postings->DocumentLengths();
+                        int until_check = 0;
+                        size_t excluded = 0;
+                        for (size_t i = 0; i < document_ids.size(); ++i) {
+                            if (control != nullptr && --until_check <= 0) {
+                                control->ThrowIfCancelled();
+                                until_check = CANCELLATION_CHECK_INTERVAL;
+                            }
+                            if (IsExcluded(plan.excluded_ids, excluded, document_ids[i])) {
+                                continue;
+                            }
+                            const uint32_t document_length = Scorer::NEEDS_LENGTHS ? document_lengths[i] : 0;
+                            document_to_relevance_cm[document_ids[i]].ref_to_value +=
+                                    scorer.Score(list.inverse_document_freq, term_freqs[i], document_length);
+                        }
+                    });
+                }
+            );
+            cancellation.Rethrow();
+            relevance_map = document_to_relevance_cm.BuildOrdinaryMap();
+        } else {
+            SEARCH_STAGE(*stats_, SearchStage::POSTING_SCAN);
+            int until_check = 0;
+            for (const ScanList& list : plus_lists) {
+                const auto& document_ids = list.postings->DocumentIds();
+                const auto& term_freqs = list.postings->TermFreqs();
+                const auto& document_lengths = list.postings->DocumentLengths();
+                size_t excluded = 0;
+                for (size_t i = 0; i < document_ids.size(); ++i) {
+                    if (control != nullptr && --until_check <= 0) {
+                        control->ThrowIfCancelled();
+                        until_check = CANCELLATION_CHECK_INTERVAL;
+                    }
+                    if (IsExcluded(plan.excluded_ids, excluded, document_ids[i])) {
+                        continue;
+                    }
+                    const uint32_t document_length = Scorer::NEEDS_LENGTHS ? document_lengths[i] : 0;
+                    relevance_map[document_ids[i]] += scorer.Score(list.inverse_document_freq, term_freqs[i], document_length);
                 }
             }
         }
+        SEARCH_COUNT(*stats_, SearchCounter::DOCUMENTS_SCORED, relevance_map.size());
+        document_to_relevance.assign(relevance_map.begin(), relevance_map.end());
     }
-    for (const std::string_view& word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
+    if (options_.store_positions && (!query.phrases.empty() || options_.proximity_weight > 0.0)) {
+        // positions are decoded only for documents that survived the term scan
+        SEARCH_STAGE(*stats_, SearchStage::POSITIONS);
+        std::vector<std::string_view> plus_words;
+        for (const QueryPlan::Term& term : plan.plus_terms) {
+            plus_words.push_back(term.word);
         }
-        for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-            document_to_relevance.erase(document_id);
+        auto kept = document_to_relevance.begin();
+        for (auto& [document_id, relevance] : document_to_relevance) {
+            const int id = document_id;
+            const bool has_phrases = std::all_of(query.phrases.begin(), query.phrases.end(),
+                                                 [&](const Phrase& phrase) {
+                                                     return DocumentHasPhrase(id, phrase);
+                                                 });
+            if (!has_phrases) {
+                continue;
+            }
+            if (options_.proximity_weight > 0.0) {
+                relevance += ComputeProximityBoost(id, plus_words);
+            }
+            *kept++ = {id, relevance};
         }
+        document_to_relevance.erase(kept, document_to_relevance.end());
     }
 
+    // the predicate runs once per candidate rather than once per posting
+    SEARCH_STAGE(*stats_, SearchStage::FILTER);
     std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance) {
-        matched_documents.push_back({document_id, relevance, documents_.at(document_id).rating});
+    for (const auto& [document_id, relevance] : document_to_relevance) {
+        const auto& document_data = documents_.at(document_id);
+        if (document_predicate(document_id, document_data.status, document_data.rating)) {
+            matched_documents.push_back({document_id, relevance, document_data.rating});
+        }
     }
     return matched_documents;
 
 }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const SearchServer::Query& query,
-                                                     DocumentPredicate document_predicate) const {
-    return FindAllDocuments(std::execution::seq, query, document_predicate);
+template <typename ExecPolicy, typename DocumentIdRange>
+std::vector<SearchServer::MatchResult> SearchServer::MatchDocuments(const ExecPolicy& policy,
+                                                                    const std::string_view raw_query,
+                                                                    const DocumentIdRange& document_ids) const {
+    SEARCH_STAGE(*stats_, SearchStage::MATCH_DOCUMENT);
+    const Query query = ParseQuery(raw_query);
+    // the parallel algorithms split only random-access ranges and would run
+    // over a std::set or the server itself sequentially
+    const std::vector<int> ids(std::begin(document_ids), std::end(document_ids));
+    std::vector<MatchResult> result(ids.size());
+    std::transform(policy,
+                   ids.begin(), ids.end(),
+                   result.begin(),
+                   [&](const int document_id) {
+                       return MatchQuery(query, document_id);
+                   });
+    return result;
+}
+
+// excluded_ids and the ids of one posting list are both ascending, so a
+// cursor that only moves forward finds every excluded posting of the list
+inline bool SearchServer::IsExcluded(const std::vector<int>& excluded_ids, size_t& cursor, int document_id) {
+    while (cursor < excluded_ids.size() && excluded_ids[cursor] < document_id) {
+        ++cursor;
+    }
+    return cursor < excluded_ids.size() && excluded_ids[cursor] == document_id;
+}
+
+template <typename Func>
+void SearchServer::ForEachDocumentWord(int document_id, Func func) const {
+    if (options_.compact) {
+        for (const std::string_view word : document_to_words_.at(document_id)) {
+            func(word);
+        }
+    } else {
+        for (const auto& [word, _] : document_to_word_freqs_.at(document_id)) {
+            func(word);
+        }
+    }
 }
 
 //out of class functions
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cmath>
+#include "search_stats.h"
+
+using std::string_literals::operator""s;
+
+namespace {
+
+int BucketIndex(uint64_t ns) {
+    int index = 0;
+    while (ns > 1 && index < HISTOGRAM_BUCKET_COUNT - 1) {
+        ns >>= 1;
+        ++index;
+    }
+    return index;
+}
+
+} // namespace
+
+const char* ToString(SearchStage stage) {
+    switch (stage) {
+        case SearchStage::PARSE: return "parse";
+        case SearchStage::POSTING_SCAN: return "posting_scan";
+        case SearchStage::MINUS_WORDS: return "minus_words";
+        case SearchStage::FILTER: return "filter";
+        case SearchStage::SORT: return "sort";
+        case SearchStage::ADD_DOCUMENT: return "add_document";
+        case SearchStage::MATCH_DOCUMENT: return "match_document";
+        case SearchStage::POSITIONS: return "positions";
+    }
+    return "unknown";
+}
+
+const char* ToString(SearchCounter counter) {
+    switch (counter) {
+        case SearchCounter::QUERIES: return "queries";
+        case SearchCounter::POSTINGS_SCANNED: return "postings_scanned";
+        case SearchCounter::DOCUMENTS_SCORED: return "documents_scored";
+        case SearchCounter::DOCUMENTS_EXCLUDED: return "documents_excluded";
+        case SearchCounter::WORD_CACHE_HITS: return "word_cache_hits";
+        case SearchCounter::WORD_CACHE_MISSES: return "word_cache_misses";
+    }
+    return "unknown";
+}
+
+uint64_t HistogramSnapshot::Percentile(double p) const {
+    if (count == 0) {
+        return 0;
+    }
+    const auto rank = static_cast<uint64_t>(std::max(1.0, std::ceil(p * count)));
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKET_COUNT; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(max_ns, (uint64_t{2} << i) - 1);
+        }
+    }
+    return max_ns;
+}
+
+HistogramSnapshot& HistogramSnapshot::operator+=(const HistogramSnapshot& other) {
+    count += other.count;
+    total_ns += other.total_ns;
+    max_ns = std::max(max_ns, other.max_ns);
+    for (int i = 0; i < HISTOGRAM_BUCKET_COUNT; ++i) {
+        buckets[i] += other.buckets[i];
+    }
+    return *this;
+}
+
+std::ostream& operator<<(std::ostream& out, const SearchStats& stats) {
+    out << "documents = "s << stats.index.document_count
+        << ", words = "s << stats.index.word_count
+        << ", postings = "s << stats.index.posting_count << '\n';
+    const IndexMemoryUsage& memory = stats.index.memory;
+    out << "memory: doc_words = "s << memory.doc_words
+        << " B, word_to_document_freqs = "s << memory.word_to_document_freqs
+        << " B, documents = "s << memory.documents
+        << " B, document_ids = "s << memory.document_ids
+        << " B, document_to_word_freqs = "s << memory.document_to_word_freqs
+        << " B, document_positions = "s << memory.document_positions
+        << " B, total = "s << memory.Total() << " B"s << '\n';
+    for (int i = 0; i < SEARCH_STAGE_COUNT; ++i) {
+        const HistogramSnapshot& stage = stats.stages[i];
+        out << ToString(static_cast<SearchStage>(i))
+            << ": count = "s << stage.count
+            << ", total = "s << stage.total_ns << " ns"s
+            << ", p50 <= "s << stage.Percentile(0.5) << " ns"s
+            << ", p99 <= "s << stage.Percentile(0.99) << " ns"s
+            << ", max = "s << stage.max_ns << " ns"s << '\n';
+    }
+    for (int i = 0; i < SEARCH_COUNTER_COUNT; ++i) {
+        out << ToString(static_cast<SearchCounter>(i)) << ": "s << stats.counters[i] << '\n';
+    }
+    return out;
+}
+
+void LatencyHistogram::Record(std::chrono::nanoseconds duration) {
+    const auto ns = static_cast<uint64_t>(std::max<int64_t>(0, duration.count()));
+    buckets_[BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    total_ns_.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t current_max = max_ns_.load(std::memory_order_relaxed);
+    while (ns > current_max
+           && !max_ns_.compare_exchange_weak(current_max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+HistogramSnapshot LatencyHistogram::Snapshot() const {
+    HistogramSnapshot snapshot;
+    snapshot.count = count_.load(std::memory_order_relaxed);
+    snapshot.total_ns = total_ns_.load(std::memory_order_relaxed);
+    snapshot.max_ns = max_ns_.load(std::memory_order_relaxed);
+    for (int i = 0; i < HISTOGRAM_BUCKET_COUNT; ++i) {
+        snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+void StatsRegistry::Record(SearchStage stage, std::chrono::nanoseconds duration) {
+    LocalShard().stages[static_cast<int>(stage)].Record(duration);
+}
+
+void StatsRegistry::Add(SearchCounter counter, uint64_t value) {
+    LocalShard().counters[static_cast<int>(counter)].fetch_add(value, std::memory_order_relaxed);
+}
+
+SearchStats StatsRegistry::Snapshot() const {
+    SearchStats stats;
+    for (const Shard& shard : shards_) {
+        for (int i = 0; i < SEARCH_STAGE_COUNT; ++i) {
+            stats.stages[i] += shard.stages[i].Snapshot();
+        }
+        for (int i = 0; i < SEARCH_COUNTER_COUNT; ++i) {
+            stats.counters[i] += shard.counters[i].load(std::memory_order_relaxed);
+        }
+    }
+    return stats;
+}
+
+// threads get shards round-robin on first use
+StatsRegistry::Shard& StatsRegistry::LocalShard() {
+    static std::atomic<size_t> next_shard{0};
+    thread_local const size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % STATS_SHARD_COUNT;
+    return shards_[shard];
+}
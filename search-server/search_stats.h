@@ -0,0 +1,129 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include "log_duration.h"
+
+// Instrumentation is compiled in only when SEARCH_SERVER_STATS is defined
+// (for every translation unit, since it changes the layout of SearchServer).
+// Without it the SEARCH_STAGE / SEARCH_COUNT macros expand to nothing.
+#ifdef SEARCH_SERVER_STATS
+#define SEARCH_STAGE(stats, stage) \
+    ScopedDuration<StatsRegistry, SearchStage> PROFILE_CONCAT(stageGuard, __LINE__)((stats), (stage))
+#define SEARCH_COUNT(stats, counter, value) (stats).Add((counter), (value))
+#else
+#define SEARCH_STAGE(stats, stage)
+#define SEARCH_COUNT(stats, counter, value)
+#endif
+
+const int HISTOGRAM_BUCKET_COUNT = 64;
+const int STATS_SHARD_COUNT = 16;
+
+enum class SearchStage {
+    PARSE,
+    POSTING_SCAN,
+    MINUS_WORDS,
+    FILTER,
+    SORT,
+    ADD_DOCUMENT,
+    MATCH_DOCUMENT,
+    POSITIONS,   // phrase checks and proximity boosting
+};
+const int SEARCH_STAGE_COUNT = 8;
+
+enum class SearchCounter {
+    QUERIES,
+    POSTINGS_SCANNED,
+    DOCUMENTS_SCORED,
+    DOCUMENTS_EXCLUDED,   // scanned documents holding a minus word, skipped when scoring
+    WORD_CACHE_HITS,   // AddDocument found the word already interned
+    WORD_CACHE_MISSES,
+};
+const int SEARCH_COUNTER_COUNT = 6;
+
+const char* ToString(SearchStage stage);
+const char* ToString(SearchCounter counter);
+
+// Bucket i holds durations in [2^i, 2^(i+1)) ns, bucket 0 also holds 0
+struct HistogramSnapshot {
+    uint64_t count = 0;
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    std::array<uint64_t, HISTOGRAM_BUCKET_COUNT> buckets{};
+
+    // upper bound of the bucket holding the p-th quantile, p in [0, 1]
+    uint64_t Percentile(double p) const;
+    HistogramSnapshot& operator+=(const HistogramSnapshot& other);
+};
+
+// bytes the index structures requested from their allocators
+struct IndexMemoryUsage {
+    size_t doc_words = 0;
+    size_t word_to_document_freqs = 0;
+    size_t documents = 0;
+    size_t document_ids = 0;
+    size_t document_to_word_freqs = 0;
+    size_t document_positions = 0;
+
+    size_t Total() const {
+        return doc_words + word_to_document_freqs + documents + document_ids + document_to_word_freqs
+               + document_positions;
+    }
+};
+
+struct IndexStats {
+    size_t document_count = 0;
+    size_t word_count = 0;
+    size_t posting_count = 0;
+    IndexMemoryUsage memory;
+};
+
+struct SearchStats {
+    std::array<HistogramSnapshot, SEARCH_STAGE_COUNT> stages{};
+    std::array<uint64_t, SEARCH_COUNTER_COUNT> counters{};
+    IndexStats index;
+
+    const HistogramSnapshot& Stage(SearchStage stage) const {
+        return stages[static_cast<int>(stage)];
+    }
+    uint64_t Counter(SearchCounter counter) const {
+        return counters[static_cast<int>(counter)];
+    }
+};
+
+std::ostream& operator<<(std::ostream& out, const SearchStats& stats);
+
+// Lock-free histogram, safe to record into from any number of threads
+class LatencyHistogram {
+public:
+    void Record(std::chrono::nanoseconds duration);
+    HistogramSnapshot Snapshot() const;
+
+private:
+    std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> total_ns_{0};
+    std::atomic<uint64_t> max_ns_{0};
+};
+
+// Stage timings and counters split into shards; each thread writes only
+// to its own shard with relaxed atomics, so recording never contends on
+// a lock and rarely on a cache line. Snapshot() merges the shards.
+class StatsRegistry {
+public:
+    void Record(SearchStage stage, std::chrono::nanoseconds duration);
+    void Add(SearchCounter counter, uint64_t value);
+    SearchStats Snapshot() const;
+
+private:
+    struct alignas(64) Shard {
+        std::array<LatencyHistogram, SEARCH_STAGE_COUNT> stages;
+        std::array<std::atomic<uint64_t>, SEARCH_COUNTER_COUNT> counters{};
+    };
+
+    std::array<Shard, STATS_SHARD_COUNT> shards_;
+
+    Shard& LocalShard();
+};
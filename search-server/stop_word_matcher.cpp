@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <stdexcept>
+#include "stop_word_matcher.h"
+
+using std::string_literals::operator""s;
+
+namespace {
+
+// seeds tried for one bucket before the table is made larger
+const uint32_t MAX_BUCKET_SEED = 1u << 16;
+
+size_t NextPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+StopWordMatcher::StopWordMatcher(const std::set<std::string, std::less<>>& words)
+        : word_count_(words.size()) {
+    if (words.empty()) {
+        return;
+    }
+    for (const std::string& word : words) {
+        if (word.empty()) {
+            throw std::invalid_argument("Stop words must not be empty"s);
+        }
+        length_mask_ |= LengthBit(word.size());
+    }
+    for (size_t slot_count = NextPowerOfTwo(words.size()); !TryBuild(words, slot_count); slot_count *= 2) {
+    }
+}
+
+std::vector<std::string_view> StopWordMatcher::Words() const {
+    std::vector<std::string_view> words;
+    words.reserve(word_count_);
+    for (const Slot& slot : slots_) {
+        if (slot.size != 0) {
+            words.emplace_back(storage_.data() + slot.offset, slot.size);
+        }
+    }
+    return words;
+}
+
+// FNV-1a, finished with a multiply so both halves of the result are mixed
+uint64_t StopWordMatcher::Hash(const std::string_view word) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const char c : word) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    return hash * 0x9E3779B97F4A7C15ull;
+}
+
+// splitmix64 finalizer of the hash displaced by the bucket's seed
+size_t StopWordMatcher::Place(uint64_t hash, uint32_t seed) const {
+    uint64_t x = hash + seed * 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x & (slots_.size() - 1);
+}
+
+// hash and displace: words are grouped into buckets by one hash, then the
+// largest buckets first search for a seed that places all their words in
+// free slots; false if some bucket finds none
+bool StopWordMatcher::TryBuild(const std::set<std::string, std::less<>>& words, size_t slot_count) {
+    storage_.clear();
+    slots_.assign(slot_count, Slot{});
+    seeds_.assign(NextPowerOfTwo(words.size() / 4 + 1), 0);
+
+    std::vector<std::vector<std::pair<uint64_t, Slot>>> buckets(seeds_.size());
+    for (const std::string& word : words) {
+        const Slot slot{static_cast<uint32_t>(storage_.size()), static_cast<uint32_t>(word.size())};
+        storage_ += word;
+        const uint64_t hash = Hash(word);
+        buckets[Bucket(hash)].emplace_back(hash, slot);
+    }
+    std::vector<size_t> order(buckets.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&buckets](size_t lhs, size_t rhs) {
+        return buckets[lhs].size() > buckets[rhs].size();
+    });
+
+    std::vector<size_t> places;
+    for (const size_t bucket : order) {
+        if (buckets[bucket].empty()) {
+            break;
+        }
+        uint32_t seed = 0;
+        for (; seed < MAX_BUCKET_SEED; ++seed) {
+            places.clear();
+            for (const auto& [hash, _] : buckets[bucket]) {
+                const size_t place = Place(hash, seed);
+                if (slots_[place].size != 0 || std::find(places.begin(), places.end(), place) != places.end()) {
+                    break;
+                }
+                places.push_back(place);
+            }
+            if (places.size() == buckets[bucket].size()) {
+                break;
+            }
+        }
+        if (seed == MAX_BUCKET_SEED) {
+            return false;
+        }
+        seeds_[bucket] = seed;
+        for (size_t i = 0; i < places.size(); ++i) {
+            slots_[places[i]] = buckets[bucket][i].second;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Membership test for a word list fixed at construction. Most tokens are
+// rejected by a bitmask of the lengths present in the list; the rest cost
+// one string hash and one comparison against the single candidate a
+// perfect hash (hash and displace) assigns to them.
+class StopWordMatcher {
+public:
+    StopWordMatcher() = default;
+    explicit StopWordMatcher(const std::set<std::string, std::less<>>& words);
+
+    bool Contains(std::string_view word) const {
+        if ((length_mask_ & LengthBit(word.size())) == 0) {
+            return false;
+        }
+        const uint64_t hash = Hash(word);
+        const Slot& slot = slots_[Place(hash, seeds_[Bucket(hash)])];
+        return std::string_view(storage_.data() + slot.offset, slot.size) == word;
+    }
+
+    // in no particular order
+    std::vector<std::string_view> Words() const;
+
+    size_t size() const {
+        return word_count_;
+    }
+    bool empty() const {
+        return word_count_ == 0;
+    }
+
+private:
+    // a word of storage_; size 0 marks a free slot, stop words are never empty
+    struct Slot {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    std::string storage_;
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> seeds_;
+    uint64_t length_mask_ = 0;
+    size_t word_count_ = 0;
+
+    static uint64_t LengthBit(size_t length) {
+        return uint64_t{1} << (length < 63 ? length : 63);
+    }
+    static uint64_t Hash(std::string_view word);
+    size_t Bucket(uint64_t hash) const {
+        return (hash >> 32) & (seeds_.size() - 1);
+    }
+    size_t Place(uint64_t hash, uint32_t seed) const;
+    bool TryBuild(const std::set<std::string, std::less<>>& words, size_t slot_count);
+};
@@ -0,0 +1,18 @@
+#include <algorithm>
+#include "string_arena.h"
+
+StringArena::StringArena(const allocator_type& allocator)
+        : allocator_(allocator)
+        , blocks_(allocator) {}
+
+std::string_view StringArena::Store(const std::string_view text) {
+    if (blocks_.empty() || blocks_.back().capacity() - blocks_.back().size() < text.size()) {
+        // an oversized word gets a block of its own
+        blocks_.emplace_back(allocator_);
+        blocks_.back().reserve(std::max(STRING_ARENA_BLOCK_SIZE, text.size()));
+    }
+    CountedVector<char>& block = blocks_.back();
+    const size_t offset = block.size();
+    block.insert(block.end(), text.begin(), text.end());
+    return {block.data() + offset, text.size()};
+}
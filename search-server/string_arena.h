@@ -0,0 +1,25 @@
+#pragma once
+#include <string_view>
+#include "counting_allocator.h"
+
+const size_t STRING_ARENA_BLOCK_SIZE = 4096;
+
+// Append-only storage for the index vocabulary. Words are copied into large
+// blocks that are never reallocated, so the returned views stay valid for
+// the lifetime of the arena and a word costs only its characters.
+class StringArena {
+public:
+    using allocator_type = CountingAllocator<char>;
+
+    explicit StringArena(const allocator_type& allocator = {});
+
+    std::string_view Store(std::string_view text);
+
+    const allocator_type& get_allocator() const {
+        return allocator_;
+    }
+
+private:
+    allocator_type allocator_;
+    CountedVector<CountedVector<char>> blocks_;
+};
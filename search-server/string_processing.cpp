@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "string_processing.h"
 
 std::vector<std::string_view> SplitIntoWords(const std::string_view str) {
@@ -12,4 +13,36 @@ std::vector<std::string_view> SplitIntoWords(const std::string_view str) {
         pos = str.find_first_not_of(" ", space);
     }
     return result;
-}
\ No newline at end of file
+}
+
+bool IsValidWord(const std::string_view word) {
+    return std::none_of(word.begin(), word.end(), [](char c) {
+        return c >= '\0' && c < ' ';
+    });
+}
+
+bool MatchesWildcard(const std::string_view pattern, const std::string_view text) {
+    size_t p = 0;
+    size_t t = 0;
+    // position of the last '*' and of the text it was matched against, to backtrack to
+    size_t star = pattern.npos;
+    size_t star_text = 0;
+    while (t < text.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+            ++p;
+            ++t;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            star_text = t;
+        } else if (star != pattern.npos) {
+            p = star + 1;
+            t = ++star_text;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+        ++p;
+    }
+    return p == pattern.size();
+}
@@ -5,6 +5,10 @@
 
 
 std::vector<std::string_view> SplitIntoWords(std::string_view text);
+// a valid word holds no control characters
+bool IsValidWord(std::string_view word);
+// '*' matches any run of characters, '?' exactly one
+bool MatchesWildcard(std::string_view pattern, std::string_view text);
 
 template <typename StringContainer>
 std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(StringContainer& strings) {
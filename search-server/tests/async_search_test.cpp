@@ -0,0 +1,177 @@
+// g++ -std=c++17 -I.. async_search_test.cpp $(ls ../*.cpp | grep -v main.cpp) -ltbb -pthread
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <execution>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "async_search.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+// a pool whose only worker is busy takes queue_capacity more tasks and
+// refuses the next; the destructor still runs everything it took
+void TestPoolRejectsWhenFull() {
+    std::atomic<int> done{0};
+    std::promise<void> release;
+    std::promise<void> started;
+    {
+        BoundedThreadPool pool(1, 2);
+        assert(pool.TrySubmit([&, gate = release.get_future().share()] {
+            started.set_value();
+            gate.wait();
+            ++done;
+        }));
+        started.get_future().wait();
+        assert(pool.TrySubmit([&] { ++done; }));
+        assert(pool.TrySubmit([&] { ++done; }));
+        assert(pool.QueueSize() == 2);
+        assert(!pool.TrySubmit([&] { ++done; }));
+        release.set_value();
+    }
+    assert(done == 3);
+
+    bool thrown = false;
+    try {
+        BoundedThreadPool pool(0, 1);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+SearchServer MakeServer(int document_count) {
+    SearchServer search_server("and"s);
+    for (int id = 0; id < document_count; ++id) {
+        search_server.AddDocument(id, "cat w"s + std::to_string(id % 97) + " w"s + std::to_string(id % 13),
+                                  id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, {id % 10});
+    }
+    return search_server;
+}
+
+bool SameIds(const std::vector<Document>& lhs, const std::vector<Document>& rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        if (lhs[i].id != rhs[i].id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// futures hold what the synchronous calls return
+void TestResultsMatchServer() {
+    const SearchServer search_server = MakeServer(1000);
+    AsyncSearchServer async_server(search_server, 2, 8);
+    auto actual = async_server.SubmitQuery("cat w5 -w7"s);
+    auto banned = async_server.SubmitQuery("w5"s, DocumentStatus::BANNED);
+    auto match = async_server.SubmitMatch("cat w3 -w5"s, 3);
+    assert(SameIds(actual.result.get(), search_server.FindTopDocuments("cat w5 -w7"s)));
+    assert(SameIds(banned.result.get(), search_server.FindTopDocuments("w5"s, DocumentStatus::BANNED)));
+    assert(match.result.get() == search_server.MatchDocument("cat w3 -w5"s, 3));
+}
+
+// a query past its deadline or cancelled before it runs fails with
+// QueryCancelled, and so does a synchronous search with a cancelled control
+void TestDeadlineAndCancel() {
+    const SearchServer search_server = MakeServer(1000);
+    AsyncSearchServer async_server(search_server, 1, 4);
+    const auto past = QueryControl::Clock::now() - std::chrono::seconds(1);
+    bool thrown = false;
+    try {
+        async_server.SubmitQuery("cat"s, DocumentStatus::ACTUAL, past).result.get();
+    } catch (const QueryCancelled&) {
+        thrown = true;
+    }
+    assert(thrown);
+    thrown = false;
+    try {
+        async_server.SubmitMatch("cat"s, 1, past).result.get();
+    } catch (const QueryCancelled&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    QueryControl control;
+    control.Cancel();
+    thrown = false;
+    try {
+        search_server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, control);
+    } catch (const QueryCancelled&) {
+        thrown = true;
+    }
+    assert(thrown);
+    assert(SameIds(search_server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, QueryControl()),
+                   search_server.FindTopDocuments("cat"s)));
+}
+
+// a cancelled control stops every task of a parallel loop without
+// terminating, and the loop's caller gets QueryCancelled afterwards
+void TestParallelCancellation() {
+    QueryControl control;
+    control.Cancel();
+    ParallelCancellation cancellation;
+    std::vector<int> blocks(64);
+    std::atomic<int> finished{0};
+    std::for_each(std::execution::par, blocks.begin(), blocks.end(), [&](int) {
+        cancellation.Run([&] {
+            control.ThrowIfCancelled();
+            ++finished;
+        });
+    });
+    assert(finished == 0);
+    bool thrown = false;
+    try {
+        cancellation.Rethrow();
+    } catch (const QueryCancelled&) {
+        thrown = true;
+    }
+    assert(thrown);
+    ParallelCancellation().Rethrow();
+}
+
+// submitting is much faster than searching, so a one-slot queue overflows
+// quickly; every accepted query still completes or reports cancellation
+void TestOverloadIsRejected() {
+    const SearchServer search_server = MakeServer(20000);
+    AsyncSearchServer async_server(search_server, 1, 1);
+    std::vector<AsyncResult<std::vector<Document>>> accepted;
+    bool rejected = false;
+    for (int i = 0; i < 100000 && !rejected; ++i) {
+        try {
+            accepted.push_back(async_server.SubmitQuery("cat w1 w2 w3"s));
+        } catch (const QueryRejected&) {
+            rejected = true;
+        }
+    }
+    assert(rejected);
+    assert(async_server.QueueSize() <= 1);
+    for (const auto& handle : accepted) {
+        handle.Cancel();
+    }
+    for (auto& handle : accepted) {
+        try {
+            assert(handle.result.get().size() == MAX_RESULT_DOCUMENT_COUNT);
+        } catch (const QueryCancelled&) {
+        }
+    }
+}
+
+}  // namespace
+
+int main() {
+    TestPoolRejectsWhenFull();
+    TestResultsMatchServer();
+    TestDeadlineAndCancel();
+    TestParallelCancellation();
+    TestOverloadIsRejected();
+    std::cout << "async_search_test OK"s << std::endl;
+}
@@ -0,0 +1,96 @@
+// g++ -std=c++17 -I.. benchmark_test.cpp $(ls ../*.cpp | grep -v main.cpp) -ltbb -pthread
+#include <cassert>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include "benchmark.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+BenchmarkResult MakeResult(std::initializer_list<int> samples) {
+    BenchmarkResult result{"case"s, {}};
+    for (const int sample : samples) {
+        result.samples.emplace_back(sample);
+    }
+    return result;
+}
+
+// nearest rank: p50 of ten samples is the fifth smallest
+void TestPercentiles() {
+    const BenchmarkResult result = MakeResult({10, 1, 9, 2, 8, 3, 7, 4, 6, 5});
+    assert(result.Total().count() == 55);
+    assert(result.Percentile(0.0).count() == 1);
+    assert(result.Percentile(0.5).count() == 5);
+    assert(result.Percentile(0.9).count() == 9);
+    assert(result.Percentile(0.99).count() == 10);
+    assert(result.Percentile(1.0).count() == 10);
+    assert(result.OperationsPerSecond() == 10 * 1e9 / 55);
+
+    const BenchmarkResult empty = MakeResult({});
+    assert(empty.Percentile(0.5).count() == 0 && empty.OperationsPerSecond() == 0.0);
+}
+
+// the same seed gives the same corpus, so runs can be compared
+void TestGeneratorsAreSeeded() {
+    std::mt19937 first(42);
+    std::mt19937 second(42);
+    const auto dictionary = GenerateDictionary(first, 100, 6);
+    assert(dictionary == GenerateDictionary(second, 100, 6));
+    assert(GenerateQueries(first, dictionary, 10, 5, 0.5) == GenerateQueries(second, dictionary, 10, 5, 0.5));
+
+    const std::string query = GenerateQuery(first, dictionary, 4, 1.0);
+    for (const std::string_view word : SplitIntoWords(query)) {
+        assert(word.size() >= 2 && word.size() <= 7 && word[0] == '-');
+    }
+}
+
+// every case runs and the CSV holds one row per case
+void TestSmallRun() {
+    BenchmarkConfig config;
+    config.document_count = 40;
+    config.dictionary_size = 30;
+    config.max_word_length = 4;
+    config.document_word_count = 5;
+    config.query_count = 4;
+    config.query_word_count = 3;
+    config.minus_prob = 0.2;
+    config.repetitions = 1;
+    const auto results = RunBenchmarks(config);
+    std::set<std::string> names;
+    for (const BenchmarkResult& result : results) {
+        assert(!result.samples.empty());
+        names.insert(result.name);
+    }
+    assert(names.size() == results.size());
+    assert(names.count("find_top_documents_seq"s) && names.count("match_documents_par"s));
+
+    std::ostringstream csv;
+    PrintBenchmarkResults(csv, config, results, BenchmarkFormat::CSV);
+    std::istringstream lines(csv.str());
+    std::string line;
+    std::getline(lines, line);
+    assert(line == "name,operations,total_ns,ops_per_sec,p50_ns,p90_ns,p99_ns,max_ns"s);
+    size_t row_count = 0;
+    while (std::getline(lines, line)) {
+        assert(names.count(line.substr(0, line.find(','))));
+        ++row_count;
+    }
+    assert(row_count == results.size());
+
+    std::ostringstream json;
+    PrintBenchmarkResults(json, config, results, BenchmarkFormat::JSON);
+    assert(json.str().find("\"documents\": 40,"s) != std::string::npos);
+    assert(json.str().find("\"name\": \"find_top_documents_bm25\""s) != std::string::npos);
+}
+
+}  // namespace
+
+int main() {
+    TestPercentiles();
+    TestGeneratorsAreSeeded();
+    TestSmallRun();
+    std::cout << "benchmark_test OK"s << std::endl;
+}
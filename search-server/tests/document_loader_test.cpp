@@ -0,0 +1,142 @@
+// g++ -std=c++17 -I.. document_loader_test.cpp $(ls ../*.cpp | grep -v main.cpp) -ltbb -pthread
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "document_loader.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+const char* STATUS_NAMES[] = {"ACTUAL", "IRRELEVANT", "BANNED", "REMOVED"};
+
+std::string DocumentText(int id) {
+    return "w"s + std::to_string(id % 17) + " w"s + std::to_string(id % 5) + " and w"s + std::to_string(id % 17);
+}
+
+// lines of increasing length, so chunks are cut at every possible offset
+std::string MakeCorpus(int document_count) {
+    std::string corpus;
+    for (int id = 0; id < document_count; ++id) {
+        corpus += std::to_string(id) + "\t"s + STATUS_NAMES[id % 4] + "\t"s;
+        corpus += id % 3 == 0 ? ""s : std::to_string(id % 10) + " -"s + std::to_string(id % 4);
+        corpus += "\t"s + DocumentText(id) + std::string(id % 11, ' ') + (id % 7 == 0 ? "\r\n"s : "\n"s);
+        if (id % 50 == 0) {
+            corpus += "\n"s;
+        }
+    }
+    return corpus;
+}
+
+void AssertSameIndex(const SearchServer& loaded, const SearchServer& expected) {
+    assert(loaded.GetDocumentCount() == expected.GetDocumentCount());
+    assert(std::equal(loaded.begin(), loaded.end(), expected.begin(), expected.end()));
+    for (const int id : expected) {
+        assert(loaded.GetWordFrequencies(id) == expected.GetWordFrequencies(id));
+        assert(std::get<DocumentStatus>(loaded.MatchDocument("w1"s, id))
+               == std::get<DocumentStatus>(expected.MatchDocument("w1"s, id)));
+    }
+    for (const auto status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED}) {
+        const auto loaded_documents = loaded.FindTopDocuments("w3 w4"s, status);
+        const auto expected_documents = expected.FindTopDocuments("w3 w4"s, status);
+        assert(loaded_documents.size() == expected_documents.size());
+        for (size_t i = 0; i < loaded_documents.size(); ++i) {
+            assert(loaded_documents[i].id == expected_documents[i].id);
+            assert(loaded_documents[i].rating == expected_documents[i].rating);
+        }
+    }
+}
+
+// whatever the chunk size and worker count, loading gives the index that
+// adding the documents one by one gives
+void TestLoadsLikeAddDocument() {
+    const int document_count = 400;
+    SearchServer expected("and"s);
+    for (int id = 0; id < document_count; ++id) {
+        std::vector<int> ratings;
+        if (id % 3 != 0) {
+            ratings = {id % 10, -(id % 4)};
+        }
+        expected.AddDocument(id, DocumentText(id), static_cast<DocumentStatus>(id % 4), ratings);
+    }
+    const std::string corpus = MakeCorpus(document_count);
+    for (const size_t chunk_size : {1u, 7u, 64u, 1u << 20}) {
+        for (const size_t worker_count : {1u, 4u}) {
+            SearchServer loaded("and"s);
+            std::istringstream input(corpus);
+            LoadOptions options;
+            options.worker_count = worker_count;
+            options.queue_capacity = 1;
+            options.chunk_size = chunk_size;
+            assert(LoadDocuments(loaded, input, options) == document_count);
+            AssertSameIndex(loaded, expected);
+        }
+    }
+}
+
+// the first bad line stops loading and is named by its number; every
+// document before it is added, none after it
+void TestStopsAtFirstBadLine() {
+    const std::string good = MakeCorpus(300);
+    const std::vector<std::pair<std::string, std::string>> bad_lines = {
+            {"300\tACTUAL\t1\n"s, "Expected id, status"s},
+            {"300\tDELETED\t1\tcat\n"s, "Invalid status DELETED"s},
+            {"300\tACTUAL\t1 x\tcat\n"s, "Invalid number x"s},
+            {"299\tACTUAL\t1\tcat\n"s, "Invalid document_id"s},
+            {"300\tACTUAL\t1\tc\x01t\n"s, "is invalid"s},
+    };
+    // 300 documents and 6 empty lines come first
+    const std::string line_prefix = "Line 307: "s;
+    for (const auto& [bad_line, message] : bad_lines) {
+        for (const size_t chunk_size : {5u, 1u << 20}) {
+            SearchServer search_server("and"s);
+            std::istringstream input(good + bad_line + "301\tACTUAL\t\tcat\n"s);
+            LoadOptions options;
+            options.worker_count = 3;
+            options.chunk_size = chunk_size;
+            std::string error;
+            try {
+                LoadDocuments(search_server, input, options);
+            } catch (const std::invalid_argument& e) {
+                error = e.what();
+            }
+            assert(error.find(line_prefix) == 0 && error.find(message) != std::string::npos);
+            assert(search_server.GetDocumentCount() == 300);
+            assert(search_server.FindTopDocuments("cat"s).empty());
+        }
+    }
+}
+
+void TestRejectsBadArguments() {
+    SearchServer search_server(""s);
+    bool thrown = false;
+    try {
+        LoadDocuments(search_server, "/nonexistent/corpus.tsv"s);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    std::istringstream input("1\tACTUAL\t\tcat\n"s);
+    LoadOptions options;
+    options.chunk_size = 0;
+    thrown = false;
+    try {
+        LoadDocuments(search_server, input, options);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown && search_server.GetDocumentCount() == 0);
+}
+
+}  // namespace
+
+int main() {
+    TestLoadsLikeAddDocument();
+    TestStopsAtFirstBadLine();
+    TestRejectsBadArguments();
+    std::cout << "document_loader_test OK"s << std::endl;
+}
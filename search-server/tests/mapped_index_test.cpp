@@ -0,0 +1,244 @@
+// g++ -std=c++17 -I.. mapped_index_test.cpp $(ls ../*.cpp | grep -v main.cpp) -ltbb -pthread
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "mapped_index.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+SearchServer MakeServer(int document_count) {
+    SearchServer search_server("and in"s);
+    for (int id = 0; id < document_count; ++id) {
+        search_server.AddDocument(id, "cat in the city number"s + std::to_string(id % 7), DocumentStatus::ACTUAL, {id});
+    }
+    return search_server;
+}
+
+// readers that have the old image mapped keep reading it after a save
+// replaces the name, whether the new image is smaller or larger
+template <typename Save, typename Open>
+void TestResaveWhileMapped(Save save, Open open) {
+    const SearchServer large = MakeServer(2000);
+    const SearchServer small = MakeServer(3);
+    save(large);
+    const MappedIndex old_index = open();
+    const auto expected = old_index.FindTopDocuments("cat number3"s);
+
+    save(small);
+    assert(old_index.GetDocumentCount() == 2000);
+    const auto after_shrink = old_index.FindTopDocuments("cat number3"s);
+    assert(after_shrink.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        assert(after_shrink[i].id == expected[i].id && after_shrink[i].relevance == expected[i].relevance);
+    }
+    assert(open().GetDocumentCount() == 3);
+
+    const MappedIndex small_index = open();
+    save(large);
+    assert(small_index.GetDocumentCount() == 3);
+    assert(small_index.FindTopDocuments("cat"s).size() == 3);
+    assert(open().GetDocumentCount() == 2000);
+}
+
+bool SameDocuments(const std::vector<Document>& lhs, const std::vector<Document>& rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        if (lhs[i].id != rhs[i].id || lhs[i].relevance != rhs[i].relevance || lhs[i].rating != rhs[i].rating) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the image answers every kind of query exactly like the server it was
+// built from, under either scoring, and so does a second process that
+// maps the same shared memory
+void TestAnswersLikeServer(const std::string& name) {
+    for (const Scoring scoring : {Scoring::TF_IDF, Scoring::BM25}) {
+        IndexOptions options;
+        options.scoring = scoring;
+        SearchServer search_server("and the"s, options);
+        for (int id = 0; id < 300; ++id) {
+            std::string text = "the w"s + std::to_string(id % 13) + " and w"s + std::to_string(id % 29);
+            for (int word = 0; word < id % 6; ++word) {
+                text += " x"s + std::to_string((id + word) % 41);
+            }
+            search_server.AddDocument(id * 3 + 1, text, static_cast<DocumentStatus>(id % 4), {id % 9, -(id % 2)});
+        }
+        SaveIndexToSharedMemory(search_server, name);
+        const MappedIndex index = MappedIndex::OpenSharedMemory(name);
+        assert(index.GetDocumentCount() == search_server.GetDocumentCount());
+        assert(std::equal(search_server.begin(), search_server.end(), index.GetDocumentIds().begin()));
+
+        const std::vector<std::string> queries = {"w1 w2 x3"s, "w1* -x1*"s, "the and"s, "w5 -w5"s,
+                                                  "x? w10 -w11"s, "nothing"s};
+        const auto odd_rating = [](int, DocumentStatus, int rating) { return rating % 2 != 0; };
+        for (const std::string& query : queries) {
+            assert(SameDocuments(index.FindTopDocuments(query), search_server.FindTopDocuments(query)));
+            for (int status = 0; status < 4; ++status) {
+                assert(SameDocuments(index.FindTopDocuments(query, static_cast<DocumentStatus>(status)),
+                                     search_server.FindTopDocuments(query, static_cast<DocumentStatus>(status))));
+            }
+            assert(SameDocuments(index.FindTopDocuments(query, odd_rating),
+                                 search_server.FindTopDocuments(query, odd_rating)));
+            for (const int id : {1, 4, 31, 895}) {
+                assert(index.MatchDocument(query, id) == search_server.MatchDocument(query, id));
+            }
+        }
+
+        const std::vector<Document> expected = search_server.FindTopDocuments("w1 w2 x3"s);
+        const pid_t child = fork();
+        if (child == 0) {
+            const MappedIndex child_index = MappedIndex::OpenSharedMemory(name);
+            _exit(SameDocuments(child_index.FindTopDocuments("w1 w2 x3"s), expected) ? 0 : 1);
+        }
+        int child_status = 0;
+        assert(child > 0 && waitpid(child, &child_status, 0) == child);
+        assert(WIFEXITED(child_status) && WEXITSTATUS(child_status) == 0);
+    }
+}
+
+uint64_t ReadOffset(const std::string& image, size_t position) {
+    uint64_t value = 0;
+    std::memcpy(&value, image.data() + position, sizeof(value));
+    return value;
+}
+
+template <typename T>
+void Patch(std::string& image, size_t position, T value) {
+    std::memcpy(image.data() + position, &value, sizeof(value));
+}
+
+bool OpensAfter(const std::string& image, const std::string& path) {
+    std::ofstream(path, std::ios::binary).write(image.data(), static_cast<std::streamsize>(image.size()));
+    try {
+        MappedIndex::OpenFile(path);
+        return true;
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+}
+
+// offsets of the header fields and records as laid out in mapped_index.cpp
+const size_t DOCUMENTS_OFFSET_FIELD = 72;
+const size_t WORDS_OFFSET_FIELD = 80;
+const size_t POSTING_DOCUMENTS_OFFSET_FIELD = 88;
+const size_t DOCUMENT_RECORD_SIZE = 16;
+const size_t DOCUMENT_STATUS_FIELD = 8;
+const size_t WORD_POSTINGS_FIELD = 16;
+
+// every field a query uses as an index or relies on being sorted is checked on open
+void TestRejectsCorruptImage(const std::string& path) {
+    SearchServer search_server(""s);
+    search_server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "cat"s, DocumentStatus::ACTUAL, {2});
+    search_server.AddDocument(3, "dog"s, DocumentStatus::BANNED, {3});
+    const std::string image = BuildIndexImage(search_server);
+    assert(OpensAfter(image, path));
+    const size_t documents = ReadOffset(image, DOCUMENTS_OFFSET_FIELD);
+    const size_t words = ReadOffset(image, WORDS_OFFSET_FIELD);
+    const size_t posting_documents = ReadOffset(image, POSTING_DOCUMENTS_OFFSET_FIELD);
+
+    std::string bad_status = image;
+    Patch<uint32_t>(bad_status, documents + DOCUMENT_STATUS_FIELD, STATUS_COUNT);
+    assert(!OpensAfter(bad_status, path));
+
+    std::string wrong_partition = image;
+    Patch<uint32_t>(wrong_partition, documents + DOCUMENT_STATUS_FIELD, static_cast<uint32_t>(DocumentStatus::BANNED));
+    assert(!OpensAfter(wrong_partition, path));
+
+    std::string unsorted_ids = image;
+    Patch<int32_t>(unsorted_ids, documents + DOCUMENT_RECORD_SIZE, 1);
+    assert(!OpensAfter(unsorted_ids, path));
+
+    // "cat" is the first word, its ACTUAL partition holds documents 0 and 1
+    std::string unsorted_postings = image;
+    Patch<int32_t>(unsorted_postings, posting_documents, 1);
+    Patch<int32_t>(unsorted_postings, posting_documents + sizeof(int32_t), 0);
+    assert(!OpensAfter(unsorted_postings, path));
+
+    std::string decreasing_offsets = image;
+    Patch<uint64_t>(decreasing_offsets, words + WORD_POSTINGS_FIELD + sizeof(uint64_t), 0);
+    Patch<uint64_t>(decreasing_offsets, words + WORD_POSTINGS_FIELD, 1);
+    assert(!OpensAfter(decreasing_offsets, path));
+}
+
+// wildcards expand as in SearchServer: minus patterns without a cap, the
+// plus cap counting only words of the searched status
+void TestPatternExpansion(const std::string& path) {
+    SearchServer search_server(""s);
+    const int word_count = static_cast<int>(MAX_EXPANDED_TERMS) + 10;
+    for (int i = 0; i < word_count; ++i) {
+        search_server.AddDocument(i, "cat pre"s + std::to_string(100 + i), DocumentStatus::BANNED, {1});
+    }
+    search_server.AddDocument(word_count, "cat prez"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(word_count + 1, "cat"s, DocumentStatus::BANNED, {1});
+    SaveIndex(search_server, path);
+    const MappedIndex index = MappedIndex::OpenFile(path);
+
+    const auto plus = index.FindTopDocuments("pre*"s);
+    assert(plus.size() == 1 && plus[0].id == word_count);
+    const auto minus = index.FindTopDocuments("cat -pre*"s, DocumentStatus::BANNED);
+    assert(minus.size() == 1 && minus[0].id == word_count + 1);
+    const auto [words, status] = index.MatchDocument("cat -pre*"s, word_count - 1);
+    assert(words.empty());
+}
+
+bool BuildsImage(const IndexOptions& options) {
+    SearchServer search_server(""s, options);
+    search_server.AddDocument(1, "new york city"s, DocumentStatus::ACTUAL, {1});
+    try {
+        BuildIndexImage(search_server);
+        return true;
+    } catch (const std::invalid_argument&) {
+        return false;
+    }
+}
+
+// options the image cannot represent would make it answer differently
+// from the server, so such servers are refused
+void TestRejectsUnrepresentableOptions() {
+    IndexOptions positions;
+    positions.store_positions = true;
+    positions.proximity_weight = 0.5;
+    assert(!BuildsImage(positions));
+    IndexOptions float_scores;
+    float_scores.score_precision = ScorePrecision::FLOAT;
+    assert(!BuildsImage(float_scores));
+
+    IndexOptions compact_bm25;
+    compact_bm25.compact = true;
+    compact_bm25.scoring = Scoring::BM25;
+    assert(BuildsImage(compact_bm25));
+}
+
+}  // namespace
+
+int main() {
+    const std::string path = "mapped_index_test.idx"s;
+    TestResaveWhileMapped([&](const SearchServer& search_server) { SaveIndex(search_server, path); },
+                          [&] { return MappedIndex::OpenFile(path); });
+    TestRejectsCorruptImage(path);
+    TestPatternExpansion(path);
+    TestRejectsUnrepresentableOptions();
+    std::remove(path.c_str());
+
+    const std::string name = "/mapped-index-test-"s + std::to_string(getpid());
+    TestResaveWhileMapped([&](const SearchServer& search_server) { SaveIndexToSharedMemory(search_server, name); },
+                          [&] { return MappedIndex::OpenSharedMemory(name); });
+    TestAnswersLikeServer(name);
+    shm_unlink(name.c_str());
+
+    std::cout << "mapped_index_test OK"s << std::endl;
+}
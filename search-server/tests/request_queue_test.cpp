@@ -0,0 +1,62 @@
+// g++ -std=c++17 -I.. request_queue_test.cpp $(ls ../*.cpp | grep -v main.cpp) -ltbb -pthread
+#include <cassert>
+#include <iostream>
+#include <string>
+#include "request_queue.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+bool SameDocuments(const std::vector<Document>& lhs, const std::vector<Document>& rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        if (lhs[i].id != rhs[i].id || lhs[i].relevance != rhs[i].relevance || lhs[i].rating != rhs[i].rating) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// each overload returns what the server's matching overload returns
+void TestRequestsMatchServer() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "curly cat"s, DocumentStatus::ACTUAL, {7});
+    search_server.AddDocument(2, "curly dog and fancy collar"s, DocumentStatus::BANNED, {1, 2});
+    search_server.AddDocument(3, "big cat fancy collar"s, DocumentStatus::ACTUAL, {5});
+    RequestQueue request_queue(search_server);
+
+    assert(SameDocuments(request_queue.AddFindRequest("curly cat"s),
+                         search_server.FindTopDocuments("curly cat"s)));
+    assert(SameDocuments(request_queue.AddFindRequest("fancy collar"s, DocumentStatus::BANNED),
+                         search_server.FindTopDocuments("fancy collar"s, DocumentStatus::BANNED)));
+    const auto even_ids = [](int document_id, DocumentStatus, int) { return document_id % 2 == 0; };
+    assert(SameDocuments(request_queue.AddFindRequest("fancy collar"s, even_ids),
+                         search_server.FindTopDocuments("fancy collar"s, even_ids)));
+}
+
+// empty results are counted over the last 1440 requests only
+void TestNoResultRequestsExpire() {
+    SearchServer search_server(""s);
+    search_server.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, {1});
+    RequestQueue request_queue(search_server);
+    for (int i = 0; i < 1439; ++i) {
+        request_queue.AddFindRequest("dog"s);
+    }
+    request_queue.AddFindRequest("cat"s);
+    assert(request_queue.GetNoResultRequests() == 1439);
+    request_queue.AddFindRequest("cat"s);
+    assert(request_queue.GetNoResultRequests() == 1438);
+    request_queue.AddFindRequest("cat"s, DocumentStatus::BANNED);
+    assert(request_queue.GetNoResultRequests() == 1438);
+}
+
+}  // namespace
+
+int main() {
+    TestRequestsMatchServer();
+    TestNoResultRequestsExpire();
+    std::cout << "request_queue_test OK"s << std::endl;
+}
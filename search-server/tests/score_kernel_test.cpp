@@ -0,0 +1,86 @@
+// g++ -std=c++17 -I.. score_kernel_test.cpp ../score_kernel.cpp
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include "score_kernel.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+// the dispatching kernels against the scalar ones on random posting lists:
+// slots left untouched (-0.0), excluded (-infinity) and touched with a zero
+// weight (+0.0) must come out bit for bit the same
+template <typename Score>
+void TestKernelsAgree(std::mt19937& generator) {
+    for (int round = 0; round < 200; ++round) {
+        const int base = static_cast<int>(generator() % 1000);
+        const size_t slot_count = 1 + generator() % 300;
+        std::vector<Score> dispatched(slot_count, static_cast<Score>(-0.0));
+        for (size_t slot = 0; slot < slot_count; ++slot) {
+            if (generator() % 10 == 0) {
+                dispatched[slot] = -std::numeric_limits<Score>::infinity();
+            }
+        }
+        std::vector<Score> scalar = dispatched;
+
+        // a few posting lists, each with distinct ascending ids and a length
+        // that is rarely a whole number of vectors
+        const int list_count = 1 + static_cast<int>(generator() % 4);
+        for (int list = 0; list < list_count; ++list) {
+            std::vector<int> document_ids;
+            std::vector<double> term_freqs;
+            for (size_t slot = 0; slot < slot_count; ++slot) {
+                if (generator() % 3 == 0) {
+                    document_ids.push_back(base + static_cast<int>(slot));
+                    term_freqs.push_back((generator() % 1000) / 997.0);
+                }
+            }
+            const double inverse_document_freq = generator() % 5 == 0 ? 0.0 : (generator() % 5000) / 1000.0;
+            AccumulateScores(document_ids.data(), term_freqs.data(), document_ids.size(),
+                             inverse_document_freq, base, dispatched.data());
+            AccumulateScoresScalar(document_ids.data(), term_freqs.data(), document_ids.size(),
+                                   inverse_document_freq, base, scalar.data());
+        }
+        assert(std::memcmp(dispatched.data(), scalar.data(), slot_count * sizeof(Score)) == 0);
+
+        std::vector<std::pair<int, double>> dispatched_result;
+        std::vector<std::pair<int, double>> scalar_result;
+        CollectScores(dispatched.data(), slot_count, base, dispatched_result);
+        CollectScoresScalar(scalar.data(), slot_count, base, scalar_result);
+        assert(dispatched_result == scalar_result);
+        for (const auto& [document_id, relevance] : scalar_result) {
+            assert(!std::signbit(scalar[document_id - base]) && relevance >= 0.0);
+        }
+    }
+}
+
+// a slot touched only with zero weight is still collected, with score 0
+template <typename Score>
+void TestZeroScoreIsCollected() {
+    std::vector<Score> scores(9, static_cast<Score>(-0.0));
+    const int document_ids[] = {12, 17};
+    const double term_freqs[] = {0.5, 0.25};
+    AccumulateScores(document_ids, term_freqs, 2, 0.0, 10, scores.data());
+    std::vector<std::pair<int, double>> result;
+    CollectScores(scores.data(), scores.size(), 10, result);
+    assert((result == std::vector<std::pair<int, double>>{{12, 0.0}, {17, 0.0}}));
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 generator(35);
+    TestKernelsAgree<double>(generator);
+    TestKernelsAgree<float>(generator);
+    TestZeroScoreIsCollected<double>();
+    TestZeroScoreIsCollected<float>();
+    // on a CPU without AVX2 the dispatching kernels are the scalar ones
+    std::cout << "score_kernel_test OK ("s
+              << (ActiveScoreKernel() == ScoreKernel::AVX2 ? "avx2"s : "scalar only"s) << ")"s << std::endl;
+}
@@ -0,0 +1,530 @@
+// g++ -std=c++17 -I.. search_server_test.cpp $(ls ../*.cpp | grep -v main.cpp) -ltbb -pthread
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <list>
+#include <string>
+#include <vector>
+#include "search_server.h"
+
+using namespace std::string_literals;
+using namespace std::string_view_literals;
+
+namespace {
+
+// prefix000 ... prefix{count - 1}, sorted as they are numbered
+std::string NumberedWord(const std::string& prefix, int number) {
+    std::string digits = std::to_string(number);
+    return prefix + std::string(3 - digits.size(), '0') + digits;
+}
+
+std::vector<int> Ids(const std::vector<Document>& documents) {
+    std::vector<int> ids;
+    for (const Document& document : documents) {
+        ids.push_back(document.id);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+// a status search sees only its own partition, and SetDocumentStatus and
+// RemoveDocument move or drop the document's postings with it
+void TestStatusPartitions() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "black cat"s, DocumentStatus::BANNED, {2});
+    search_server.AddDocument(3, "cat and dog"s, DocumentStatus::IRRELEVANT, {3});
+
+    assert(Ids(search_server.FindTopDocuments("cat"s)) == std::vector<int>{1});
+    assert(Ids(search_server.FindTopDocuments("cat"s, DocumentStatus::BANNED)) == std::vector<int>{2});
+    assert(Ids(search_server.FindTopDocuments(std::execution::par, "cat"s, DocumentStatus::IRRELEVANT))
+           == std::vector<int>{3});
+    assert(search_server.FindTopDocuments("cat"s, DocumentStatus::REMOVED).empty());
+    const auto any_status = [](int, DocumentStatus, int) { return true; };
+    assert((Ids(search_server.FindTopDocuments("cat"s, any_status)) == std::vector<int>{1, 2, 3}));
+
+    search_server.SetDocumentStatus(2, DocumentStatus::ACTUAL);
+    assert((Ids(search_server.FindTopDocuments("cat"s)) == std::vector<int>{1, 2}));
+    assert(search_server.FindTopDocuments("cat"s, DocumentStatus::BANNED).empty());
+    assert(std::get<DocumentStatus>(search_server.MatchDocument("black"s, 2)) == DocumentStatus::ACTUAL);
+
+    search_server.RemoveDocument(1);
+    assert(Ids(search_server.FindTopDocuments("cat"s)) == std::vector<int>{2});
+    assert(search_server.FindTopDocuments("white"s, any_status).empty());
+
+    bool thrown = false;
+    try {
+        search_server.SetDocumentStatus(1, DocumentStatus::BANNED);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+// a repeated word is indexed once with its share of the document's
+// non-stop words, and the index keeps its own copy of the text
+void TestAddDocumentCountsRepeatedWords() {
+    SearchServer search_server("and"s);
+    {
+        std::string text = "cat dog cat and cat"s;
+        search_server.AddDocument(1, text, DocumentStatus::ACTUAL, {4, 2});
+        text.assign(text.size(), 'x');
+    }
+    const SearchServer::WordFrequencies& frequencies = search_server.GetWordFrequencies(1);
+    assert(frequencies.size() == 2 && frequencies.at("cat"s) == 0.75 && frequencies.at("dog"s) == 0.25);
+    const SearchStats stats = search_server.GetStats();
+    assert(stats.index.word_count == 2 && stats.index.posting_count == 2);
+
+    // the two stages give the same index as AddDocument
+    const std::string text = "dog bird"s;
+    search_server.AddDocument(search_server.ParseDocument(2, text, DocumentStatus::ACTUAL, {1}));
+    assert(search_server.GetWordFrequencies(2).at("bird"s) == 0.5);
+    const auto documents = search_server.FindTopDocuments("cat"s);
+    assert(documents.size() == 1 && documents[0].id == 1 && documents[0].rating == 3);
+    assert(std::abs(documents[0].relevance - 0.75 * std::log(2.0)) < 1e-12);
+
+    for (const int bad_id : {-1, 1}) {
+        bool thrown = false;
+        try {
+            search_server.AddDocument(bad_id, "fox"s, DocumentStatus::ACTUAL, {1});
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+    bool thrown = false;
+    try {
+        search_server.AddDocument(3, "fox\x01"s, DocumentStatus::ACTUAL, {1});
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown && search_server.GetDocumentCount() == 2);
+    assert(search_server.FindTopDocuments("fox"s).empty());
+}
+
+// compact mode answers like the default mode from less memory, and every
+// figure returns to its empty value once the documents are removed
+void TestMemoryAccounting() {
+    IndexOptions compact_options;
+    compact_options.compact = true;
+    SearchServer full(""s);
+    SearchServer compact(""s, compact_options);
+    const IndexMemoryUsage empty_usage = full.MemoryUsage();
+    for (int id = 0; id < 200; ++id) {
+        std::string text;
+        for (int word = 0; word < 20; ++word) {
+            text += NumberedWord("w"s, (id * 7 + word * 13) % 300) + " "s;
+        }
+        full.AddDocument(id, text, DocumentStatus::ACTUAL, {id});
+        compact.AddDocument(id, text, DocumentStatus::ACTUAL, {id});
+    }
+
+    const IndexMemoryUsage full_usage = full.MemoryUsage();
+    const IndexMemoryUsage compact_usage = compact.MemoryUsage();
+    assert(full_usage.doc_words > 0 && full_usage.word_to_document_freqs > 0 && full_usage.documents > 0
+           && full_usage.document_ids > 0 && full_usage.document_to_word_freqs > 0);
+    assert(full_usage.document_positions == 0);
+    assert(compact_usage.document_to_word_freqs < full_usage.document_to_word_freqs);
+    assert(compact_usage.Total() < full_usage.Total());
+
+    for (const std::string& query : {"w001 w002 -w003"s, "w1*"s, "w010 w250"s}) {
+        assert(Ids(full.FindTopDocuments(query)) == Ids(compact.FindTopDocuments(query)));
+    }
+    for (int id = 0; id < 200; id += 17) {
+        const SearchServer::WordFrequencies expected = full.GetWordFrequencies(id);
+        assert(expected.size() > 0 && compact.GetWordFrequencies(id) == expected);
+    }
+
+    // the counters stay with the index when the server moves
+    SearchServer moved = std::move(full);
+    assert(moved.MemoryUsage().Total() == full_usage.Total());
+    for (int id = 0; id < 200; ++id) {
+        moved.RemoveDocument(id);
+    }
+    const IndexMemoryUsage removed_usage = moved.MemoryUsage();
+    assert(removed_usage.documents == empty_usage.documents);
+    assert(removed_usage.document_ids == empty_usage.document_ids);
+    assert(removed_usage.document_to_word_freqs == empty_usage.document_to_word_freqs);
+}
+
+// walking the pages by token or by number visits every result once, in
+// result order, even with ties in relevance
+void TestPaging() {
+    SearchServer search_server(""s);
+    for (int id = 0; id < 23; ++id) {
+        search_server.AddDocument(id, id % 3 == 0 ? "cat dog"s : "cat"s, DocumentStatus::ACTUAL, {id % 4});
+    }
+    PageRequest all_request;
+    all_request.page_size = 100;
+    const SearchPage all = search_server.FindTopDocuments("cat dog"s, all_request);
+    assert(all.size() == 23 && !all.NextPage());
+    for (size_t i = 1; i < all.size(); ++i) {
+        assert(IsRankedHigher(all[i - 1], all[i]));
+    }
+    const auto first_five = search_server.FindTopDocuments("cat dog"s);
+    assert(std::equal(first_five.begin(), first_five.end(), all.begin(), [](const Document& lhs, const Document& rhs) {
+        return lhs.id == rhs.id;
+    }));
+
+    PageRequest request;
+    request.page_size = 5;
+    std::vector<int> by_token;
+    std::vector<int> by_number;
+    for (size_t page_number = 0;; ++page_number) {
+        request.page = page_number;
+        request.after.reset();
+        const SearchPage numbered = search_server.FindTopDocuments("cat dog"s, request);
+        if (numbered.empty()) {
+            assert(page_number == 5);
+            break;
+        }
+        for (const Document& document : numbered) {
+            by_number.push_back(document.id);
+        }
+    }
+    request.page = 0;
+    request.after.reset();
+    for (int page_count = 1;; ++page_count) {
+        const SearchPage page = search_server.FindTopDocuments("cat dog"s, request);
+        assert(page.size() == (page_count < 5 ? 5u : 3u));
+        for (const Document& document : page) {
+            by_token.push_back(document.id);
+        }
+        if (!page.NextPage()) {
+            assert(page_count == 5);
+            break;
+        }
+        request.after = page.NextPage();
+    }
+    std::vector<int> expected;
+    for (const Document& document : all) {
+        expected.push_back(document.id);
+    }
+    assert(by_token == expected && by_number == expected);
+
+    // a token still continues after the document it names is gone; the
+    // eight documents with "dog" come first, so removing a later one keeps
+    // the weights
+    assert(all[7].relevance > 0.0 && all[9].relevance == 0.0);
+    request.after = PageToken{all[9].relevance, all[9].rating, all[9].id};
+    search_server.RemoveDocument(all[9].id);
+    const SearchPage after_removal = search_server.FindTopDocuments("cat dog"s, request);
+    assert(after_removal.size() == 5 && after_removal[0].id == all[10].id);
+
+    request.page_size = 0;
+    bool thrown = false;
+    try {
+        search_server.FindTopDocuments("cat dog"s, request);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+template <typename Func>
+bool ThrowsInvalidArgument(Func func) {
+    try {
+        func();
+    } catch (const std::invalid_argument&) {
+        return true;
+    }
+    return false;
+}
+
+// a phrase needs its words at the same offsets as in the query, a stop
+// word inside it still takes a position, and the phrase only filters
+void TestPhrases() {
+    IndexOptions options;
+    options.store_positions = true;
+    SearchServer search_server("the"s, options);
+    search_server.AddDocument(1, "the quick brown fox"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "brown quick fox"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(3, "quick the brown fox"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(4, "quick and brown dog"s, DocumentStatus::ACTUAL, {1});
+
+    assert(Ids(search_server.FindTopDocuments("\"quick brown\""s)) == std::vector<int>{1});
+    // any word fills the stop word's place
+    assert((Ids(search_server.FindTopDocuments("\"quick the brown\""s)) == std::vector<int>{3, 4}));
+    assert(Ids(search_server.FindTopDocuments("\"quick brown\" dog"s)) == std::vector<int>{1});
+    assert((Ids(search_server.FindTopDocuments(std::execution::par, "\"brown fox\""s)) == std::vector<int>{1, 3}));
+    assert((Ids(search_server.FindTopDocuments("\"fox\""s)) == std::vector<int>{1, 2, 3}));
+
+    assert(ThrowsInvalidArgument([&] { search_server.FindTopDocuments("\"quick brown"s); }));
+    assert(ThrowsInvalidArgument([&] { search_server.FindTopDocuments("fox -\"quick brown\""s); }));
+    assert(ThrowsInvalidArgument([&] { search_server.FindTopDocuments("\"quick bro*\""s); }));
+
+    // without positions a quote is part of the word
+    SearchServer plain("the"s);
+    plain.AddDocument(1, "the quick brown fox"s, DocumentStatus::ACTUAL, {1});
+    assert(plain.FindTopDocuments("\"quick brown\""s).empty());
+}
+
+// the boost is proximity_weight over the smallest distance between two
+// different query words
+void TestProximityBoost() {
+    IndexOptions options;
+    options.store_positions = true;
+    options.proximity_weight = 1.0;
+    SearchServer search_server(""s, options);
+    search_server.AddDocument(1, "cat dog x x x"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "cat x x x dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(3, "cat x x x x"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(4, "y y y y y"s, DocumentStatus::ACTUAL, {1});
+
+    const auto documents = search_server.FindTopDocuments("cat dog"s);
+    assert(documents.size() == 3 && documents[0].id == 1 && documents[1].id == 2 && documents[2].id == 3);
+    assert(std::abs(documents[0].relevance - documents[1].relevance - (1.0 - 0.25)) < 1e-12);
+
+    // without a weight the two documents tie and the lower id goes first
+    options.proximity_weight = 0.0;
+    SearchServer unboosted(""s, options);
+    unboosted.AddDocument(1, "cat x x x dog"s, DocumentStatus::ACTUAL, {1});
+    unboosted.AddDocument(2, "cat dog x x x"s, DocumentStatus::ACTUAL, {1});
+    const auto unboosted_documents = unboosted.FindTopDocuments("cat dog"s);
+    assert(unboosted_documents.size() == 2 && unboosted_documents[0].id == 1);
+    assert(unboosted_documents[0].relevance == unboosted_documents[1].relevance);
+}
+
+// '?' stands for one character and '*' for any run, the empty one too
+void TestWildcards() {
+    assert(MatchesWildcard("ca?"s, "cat"s) && !MatchesWildcard("ca?"s, "ca"s) && !MatchesWildcard("ca?"s, "cats"s));
+    assert(MatchesWildcard("ca*"s, "ca"s) && MatchesWildcard("c*t*"s, "coat"s) && MatchesWildcard("c*s"s, "cats"s));
+    assert(!MatchesWildcard("c*s"s, "cat"s) && MatchesWildcard("c?*t"s, "coat"s) && !MatchesWildcard("c?*t"s, "ct"s));
+
+    SearchServer search_server("can"s);
+    search_server.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "cats"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(3, "coat"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(4, "dog can"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(5, "cab"s, DocumentStatus::BANNED, {1});
+
+    assert(Ids(search_server.FindTopDocuments("ca?"s)) == std::vector<int>{1});
+    assert((Ids(search_server.FindTopDocuments("ca*"s)) == std::vector<int>{1, 2}));
+    assert((Ids(search_server.FindTopDocuments("c*t"s)) == std::vector<int>{1, 3}));
+    assert(Ids(search_server.FindTopDocuments("ca?"s, DocumentStatus::BANNED)) == std::vector<int>{5});
+    assert((Ids(search_server.FindTopDocuments("c* -ca?"s)) == std::vector<int>{2, 3}));
+    assert(Ids(search_server.FindTopDocuments("dog -ca?"s)) == std::vector<int>{4});
+
+    const auto [words, status] = search_server.MatchDocument("c?t* dog"s, 2);
+    assert(words.size() == 1 && words[0] == "cats"s);
+    assert(ThrowsInvalidArgument([&] { search_server.FindTopDocuments("*at"s); }));
+    assert(ThrowsInvalidArgument([&] { search_server.FindTopDocuments("-?at"s); }));
+    assert(ThrowsInvalidArgument([&] { search_server.FindTopDocuments("cat --dog"s); }));
+}
+
+// contiguous ids are scored in the dense array, ids spread far apart in
+// a map; both must rank alike, and float accumulators only round
+void TestDenseAndSparseScoresAgree() {
+    IndexOptions float_options;
+    float_options.score_precision = ScorePrecision::FLOAT;
+    SearchServer dense(""s);
+    SearchServer dense_float(""s, float_options);
+    SearchServer sparse(""s);
+    for (int i = 0; i < 3000; ++i) {
+        std::string text;
+        for (int word = 0; word < 6; ++word) {
+            text += NumberedWord("w"s, (i * 31 + word * word * 7) % 97) + " "s;
+        }
+        dense.AddDocument(i, text, DocumentStatus::ACTUAL, {i % 7});
+        dense_float.AddDocument(i, text, DocumentStatus::ACTUAL, {i % 7});
+        sparse.AddDocument(i * 1000, text, DocumentStatus::ACTUAL, {i % 7});
+    }
+    PageRequest request;
+    request.page_size = 50;
+    for (const std::string& query : {"w001 w002 w050"s, "w010 -w011"s, "w00* w090"s}) {
+        const SearchPage expected = sparse.FindTopDocuments(query, request);
+        for (const SearchPage& page : {dense.FindTopDocuments(query, request),
+                                       dense_float.FindTopDocuments(query, request)}) {
+            assert(page.size() == expected.size() && !page.empty());
+            for (size_t i = 0; i < page.size(); ++i) {
+                assert(std::abs(page[i].relevance - expected[i].relevance) < 1e-5);
+            }
+        }
+        const SearchPage exact = dense.FindTopDocuments(query, request);
+        for (size_t i = 0; i < exact.size(); ++i) {
+            assert(exact[i].id * 1000 == expected[i].id && exact[i].relevance == expected[i].relevance);
+        }
+        const auto par = dense.FindTopDocuments(std::execution::par, query);
+        assert(par.size() == MAX_RESULT_DOCUMENT_COUNT && par[0].id == exact[0].id);
+    }
+}
+
+// matched words are the document's plus words in order, none if it holds
+// a minus word; the batch form agrees with one call per document over any
+// kind of id range, and the words outlive the query text
+void TestMatchDocuments() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "white cat and fancy collar"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::BANNED, {1});
+    search_server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(4, "fluffy dog collar"s, DocumentStatus::IRRELEVANT, {1});
+
+    std::string query = "fluffy collar cat and -eyes"s;
+    const auto [words, status] = search_server.MatchDocument(std::execution::par, query, 2);
+    assert((words == std::vector<std::string_view>{"cat"sv, "fluffy"sv}) && status == DocumentStatus::BANNED);
+    assert(std::get<0>(search_server.MatchDocument(query, 3)).empty());
+    query.assign(query.size(), 'x');
+    assert(words[0] == "cat"sv);
+
+    const std::string batch_query = "fluffy collar cat -eyes"s;
+    std::vector<SearchServer::MatchResult> expected;
+    for (const int id : search_server) {
+        expected.push_back(search_server.MatchDocument(batch_query, id));
+    }
+    assert(search_server.MatchDocuments(std::execution::seq, batch_query, search_server) == expected);
+    assert(search_server.MatchDocuments(std::execution::par, batch_query, search_server) == expected);
+    const std::list<int> reversed{4, 3, 2, 1};
+    const auto reversed_result = search_server.MatchDocuments(std::execution::par, batch_query, reversed);
+    assert(std::equal(reversed_result.begin(), reversed_result.end(), expected.rbegin(), expected.rend()));
+    assert(search_server.MatchDocuments(std::execution::par, batch_query, std::vector<int>{}).empty());
+
+    bool thrown = false;
+    try {
+        search_server.MatchDocument(batch_query, 5);
+    } catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+// the plan scans words from the shortest posting list up, drops words
+// without postings in the searched statuses and counts what minus words
+// exclude; the search it describes gives the same results
+void TestQueryPlan() {
+    SearchServer search_server(""s);
+    for (int id = 0; id < 10; ++id) {
+        std::string text = "common"s;
+        if (id < 4) {
+            text += " mid"s;
+        }
+        if (id == 0) {
+            text += " rare"s;
+        }
+        if (id % 5 == 1) {
+            text += " bad"s;
+        }
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, {id});
+    }
+    search_server.AddDocument(10, "hidden common"s, DocumentStatus::BANNED, {1});
+
+    const std::string plan = search_server.ExplainQuery("common rare mid hidden ghost -bad -ghost"s);
+    assert(plan.find("status: ACTUAL\nscoring: tf-idf\nscan: 3 words, 15 postings"s) == 0);
+    const size_t rare = plan.find("  rare: 1 postings"s);
+    const size_t mid = plan.find("  mid: 4 postings"s);
+    const size_t common = plan.find("  common: 10 postings"s);
+    assert(rare != std::string::npos && rare < mid && mid < common && common != std::string::npos);
+    assert(plan.find("dropped (no postings): ghost hidden\n"s) != std::string::npos);
+    assert(plan.find("exclude: 2 documents\n  -bad: 2 postings\n"s) != std::string::npos);
+
+    const auto documents = search_server.FindTopDocuments("common rare mid hidden ghost -bad -ghost"s);
+    assert(documents.size() == MAX_RESULT_DOCUMENT_COUNT && documents[0].id == 0);
+    for (const Document& document : documents) {
+        assert(document.id % 5 != 1 && document.id != 10);
+    }
+
+    // over every status the banned word has postings
+    const std::string any_plan = search_server.ExplainQuery("hidden common"s, std::nullopt);
+    assert(any_plan.find("status: any\n"s) == 0 && any_plan.find("dropped"s) == std::string::npos);
+    assert(any_plan.find("  hidden: 1 postings"s) < any_plan.find("  common: 11 postings"s));
+    assert(search_server.ExplainQuery("ghost -common"s).find("no results"s) != std::string::npos);
+}
+
+// a minus pattern excludes every document holding any word it matches,
+// however many words that is
+void TestMinusPatternIsNotCapped() {
+    SearchServer search_server(""s);
+    const int word_count = static_cast<int>(MAX_EXPANDED_TERMS) + 10;
+    for (int i = 0; i < word_count; ++i) {
+        search_server.AddDocument(i, "cat "s + NumberedWord("pre"s, i), DocumentStatus::ACTUAL, {1});
+    }
+    search_server.AddDocument(word_count, "cat dog"s, DocumentStatus::ACTUAL, {1});
+
+    const auto documents = search_server.FindTopDocuments("cat -pre*"s);
+    assert(documents.size() == 1 && documents[0].id == word_count);
+    const auto documents_par = search_server.FindTopDocuments(std::execution::par, "cat -pre*"s);
+    assert(documents_par.size() == 1 && documents_par[0].id == word_count);
+
+    const auto [words, status] = search_server.MatchDocument("cat -pre*"s, word_count - 1);
+    assert(words.empty());
+}
+
+// the plus cap counts only words with postings in the searched status, so
+// words of other statuses cannot crowd out the ones that match
+void TestPlusPatternCapCountsSearchedStatus() {
+    SearchServer search_server(""s);
+    const int banned_count = static_cast<int>(MAX_EXPANDED_TERMS) + 10;
+    for (int i = 0; i < banned_count; ++i) {
+        search_server.AddDocument(i, NumberedWord("pre"s, i), DocumentStatus::BANNED, {1});
+    }
+    search_server.AddDocument(banned_count, "prez"s, DocumentStatus::ACTUAL, {1});
+
+    const auto documents = search_server.FindTopDocuments("pre*"s);
+    assert(documents.size() == 1 && documents[0].id == banned_count);
+    const auto [words, status] = search_server.MatchDocument("pre*"s, banned_count);
+    assert(words.size() == 1 && words[0] == "prez"s);
+
+    // over all statuses the cap still holds
+    PageRequest page_request;
+    page_request.page_size = 1000;
+    const auto page = search_server.FindTopDocuments(
+            "pre*"s, [](int, DocumentStatus, int) { return true; }, page_request);
+    assert(page.size() == MAX_EXPANDED_TERMS);
+}
+
+// BM25 against the formula worked out by hand: "cat" is in 2 of 3
+// documents and the average length is 2
+void TestBm25Score() {
+    IndexOptions options;
+    options.scoring = Scoring::BM25;
+    SearchServer search_server(""s, options);
+    search_server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "cat"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(3, "dog dog bird"s, DocumentStatus::ACTUAL, {1});
+
+    const double weight = std::log(1.0 + (3 - 2 + 0.5) / (2 + 0.5));
+    // k1 = 1.2, b = 0.75: score = weight * tf * (k1 + 1) / (tf + k1 * (1 - b + b * length / 2))
+    const auto documents = search_server.FindTopDocuments("cat"s);
+    assert(documents.size() == 2);
+    assert(documents[0].id == 2 && std::abs(documents[0].relevance - weight * 2.2 / 1.75) < 1e-12);
+    assert(documents[1].id == 1 && std::abs(documents[1].relevance - weight) < 1e-12);
+}
+
+void TestBm25ParametersAreValidated() {
+    for (const auto& [k1, b] : {std::pair{-0.1, 0.75}, std::pair{1.2, -0.1}, std::pair{1.2, 1.1},
+                               std::pair{std::nan(""), 0.75}}) {
+        IndexOptions options;
+        options.scoring = Scoring::BM25;
+        options.bm25 = {k1, b};
+        bool thrown = false;
+        try {
+            SearchServer search_server(""s, options);
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+    IndexOptions options;
+    options.bm25 = {0.0, 1.0};
+    SearchServer search_server(""s, options);
+}
+
+}  // namespace
+
+int main() {
+    TestStatusPartitions();
+    TestAddDocumentCountsRepeatedWords();
+    TestMemoryAccounting();
+    TestPaging();
+    TestPhrases();
+    TestProximityBoost();
+    TestMatchDocuments();
+    TestWildcards();
+    TestMinusPatternIsNotCapped();
+    TestPlusPatternCapCountsSearchedStatus();
+    TestDenseAndSparseScoresAgree();
+    TestQueryPlan();
+    TestBm25Score();
+    TestBm25ParametersAreValidated();
+    std::cout << "search_server_test OK"s << std::endl;
+}
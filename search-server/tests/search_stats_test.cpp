@@ -0,0 +1,99 @@
+// g++ -std=c++17 [-DSEARCH_SERVER_STATS] -I.. search_stats_test.cpp $(ls ../*.cpp | grep -v main.cpp) -ltbb -pthread
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "search_server.h"
+
+using namespace std::string_literals;
+using std::chrono::nanoseconds;
+
+namespace {
+
+// bucket i holds [2^i, 2^(i+1)) ns, and percentiles report its upper bound
+// capped by the largest duration seen
+void TestHistogram() {
+    LatencyHistogram histogram;
+    for (const int ns : {0, 1, 3, 5, 6, 7, 1000}) {
+        histogram.Record(nanoseconds(ns));
+    }
+    histogram.Record(nanoseconds(-5));
+    const HistogramSnapshot snapshot = histogram.Snapshot();
+    assert(snapshot.count == 8 && snapshot.total_ns == 1022 && snapshot.max_ns == 1000);
+    assert(snapshot.buckets[0] == 3 && snapshot.buckets[1] == 1 && snapshot.buckets[2] == 3
+           && snapshot.buckets[9] == 1);
+    assert(snapshot.Percentile(0.25) == 1);
+    assert(snapshot.Percentile(0.5) == 3);
+    assert(snapshot.Percentile(0.75) == 7);
+    assert(snapshot.Percentile(1.0) == 1000);
+    assert(HistogramSnapshot{}.Percentile(0.5) == 0);
+}
+
+// shards written from several threads add up in the snapshot
+void TestRegistryMergesThreads() {
+    StatsRegistry registry;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&registry] {
+            for (int i = 0; i < 1000; ++i) {
+                registry.Add(SearchCounter::POSTINGS_SCANNED, 2);
+                registry.Record(SearchStage::PARSE, nanoseconds(i));
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    const SearchStats stats = registry.Snapshot();
+    assert(stats.Counter(SearchCounter::POSTINGS_SCANNED) == 8000);
+    assert(stats.Stage(SearchStage::PARSE).count == 4000 && stats.Stage(SearchStage::PARSE).max_ns == 999);
+    assert(stats.Stage(SearchStage::SORT).count == 0);
+}
+
+// index figures are filled in every build, timings and counters only
+// when the server is built with SEARCH_SERVER_STATS
+void TestServerStats() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "cat and dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "cat bird"s, DocumentStatus::ACTUAL, {1});
+    search_server.FindTopDocuments("cat -bird"s);
+    search_server.FindTopDocuments(std::execution::par, "dog"s);
+
+    const SearchStats stats = search_server.GetStats();
+    assert(stats.index.document_count == 2 && stats.index.word_count == 3 && stats.index.posting_count == 4);
+    assert(stats.index.memory.Total() == search_server.MemoryUsage().Total());
+#ifdef SEARCH_SERVER_STATS
+    assert(stats.Counter(SearchCounter::QUERIES) == 2);
+    assert(stats.Counter(SearchCounter::WORD_CACHE_MISSES) == 3);
+    assert(stats.Counter(SearchCounter::WORD_CACHE_HITS) == 1);
+    assert(stats.Counter(SearchCounter::DOCUMENTS_EXCLUDED) == 1);
+    assert(stats.Stage(SearchStage::ADD_DOCUMENT).count == 2);
+#else
+    for (int i = 0; i < SEARCH_COUNTER_COUNT; ++i) {
+        assert(stats.counters[i] == 0);
+    }
+    for (int i = 0; i < SEARCH_STAGE_COUNT; ++i) {
+        assert(stats.stages[i].count == 0);
+    }
+#endif
+
+    std::ostringstream out;
+    out << stats;
+    assert(out.str().find("documents = 2, words = 3, postings = 4"s) == 0);
+}
+
+}  // namespace
+
+int main() {
+    TestHistogram();
+    TestRegistryMergesThreads();
+    TestServerStats();
+#ifdef SEARCH_SERVER_STATS
+    std::cout << "search_stats_test OK (instrumented)"s << std::endl;
+#else
+    std::cout << "search_stats_test OK"s << std::endl;
+#endif
+}
@@ -0,0 +1,78 @@
+// g++ -std=c++17 -I.. stop_word_matcher_test.cpp ../stop_word_matcher.cpp
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "stop_word_matcher.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+std::string RandomWord(std::mt19937& generator, size_t max_length) {
+    std::string word(1 + generator() % max_length, ' ');
+    for (char& c : word) {
+        c = static_cast<char>('a' + generator() % 4);
+    }
+    return word;
+}
+
+// the matcher answers like the set it was built from, for word sets from
+// empty to thousands and for probes sharing lengths and prefixes with them
+void TestAgreesWithSet() {
+    std::mt19937 generator(38);
+    for (const size_t word_count : {0u, 1u, 2u, 5u, 40u, 300u, 3000u}) {
+        std::set<std::string, std::less<>> words;
+        while (words.size() < word_count) {
+            words.insert(RandomWord(generator, 8));
+        }
+        const StopWordMatcher matcher(words);
+        assert(matcher.size() == words.size() && matcher.empty() == words.empty());
+        for (const std::string& word : words) {
+            assert(matcher.Contains(word));
+        }
+        for (int i = 0; i < 20000; ++i) {
+            const std::string probe = RandomWord(generator, 9);
+            assert(matcher.Contains(probe) == (words.count(probe) > 0));
+        }
+        assert(!matcher.Contains(""s));
+
+        std::vector<std::string_view> listed = matcher.Words();
+        std::sort(listed.begin(), listed.end());
+        assert(std::equal(listed.begin(), listed.end(), words.begin(), words.end()));
+    }
+}
+
+// lengths of 63 and more share one bit of the length mask
+void TestLongWords() {
+    const std::string long_word(100, 'x');
+    const StopWordMatcher matcher(std::set<std::string, std::less<>>{"a"s, long_word});
+    assert(matcher.Contains(long_word) && matcher.Contains("a"s));
+    assert(!matcher.Contains(std::string(63, 'x')) && !matcher.Contains(std::string(101, 'x')));
+    assert(!matcher.Contains(std::string_view(long_word).substr(1)));
+}
+
+void TestRejectsEmptyWord() {
+    bool thrown = false;
+    try {
+        StopWordMatcher(std::set<std::string, std::less<>>{""s, "and"s});
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+    assert(!StopWordMatcher().Contains("and"s) && StopWordMatcher().empty());
+}
+
+}  // namespace
+
+int main() {
+    TestAgreesWithSet();
+    TestLongWords();
+    TestRejectsEmptyWord();
+    std::cout << "stop_word_matcher_test OK"s << std::endl;
+}
@@ -0,0 +1,39 @@
+#include <stdexcept>
+#include "thread_pool.h"
+
+using std::string_literals::operator""s;
+
+BoundedThreadPool::BoundedThreadPool(size_t thread_count, size_t queue_capacity)
+        : tasks_(queue_capacity) {
+    if (thread_count == 0) {
+        throw std::invalid_argument("Thread pool needs at least one thread"s);
+    }
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back([this] {
+            WorkerLoop();
+        });
+    }
+}
+
+BoundedThreadPool::~BoundedThreadPool() {
+    tasks_.Close();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+bool BoundedThreadPool::TrySubmit(std::function<void()> task) {
+    return tasks_.TryPush(std::move(task));
+}
+
+size_t BoundedThreadPool::QueueSize() const {
+    return tasks_.Size();
+}
+
+// Pop keeps handing out queued tasks after Close, so the pool drains
+void BoundedThreadPool::WorkerLoop() {
+    while (auto task = tasks_.Pop()) {
+        (*task)();
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <functional>
+#include <thread>
+#include <vector>
+#include "bounded_queue.h"
+
+// Fixed set of worker threads fed from a queue of limited capacity.
+// TrySubmit refuses work when the queue is full (admission control).
+// The destructor finishes every task already queued.
+class BoundedThreadPool {
+public:
+    BoundedThreadPool(size_t thread_count, size_t queue_capacity);
+    ~BoundedThreadPool();
+
+    BoundedThreadPool(const BoundedThreadPool&) = delete;
+    BoundedThreadPool& operator=(const BoundedThreadPool&) = delete;
+
+    bool TrySubmit(std::function<void()> task);
+
+    size_t QueueSize() const;
+
+private:
+    BoundedQueue<std::function<void()>> tasks_;
+    std::vector<std::thread> workers_;
+
+    void WorkerLoop();
+};